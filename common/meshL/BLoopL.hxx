@@ -43,20 +43,7 @@ public:
   std::list<std::shared_ptr<BLoopL> >::iterator biter() const { return iterb_; }
 
   std::shared_ptr<HalfedgeL> findHalfedgeBloop( std::shared_ptr<VertexL> o, std::shared_ptr<VertexL> vt ) {
-    VertexLCirculator vc( o );
-    std::shared_ptr<HalfedgeL> he = vc.beginHalfedgeL();
-    do {
-      if ( he->next()->vertex() == vt ) return he;
-
-      std::shared_ptr<HalfedgeL> mate = he->mate();
-      if ( mate )
-      {
-        if ( mate->vertex() == vt ) return mate;
-      }
-      he = vc.nextHalfedgeL();
-    } while ( (he != nullptr) && (he != vc.firstHalfedgeL()) );
-
-    return nullptr;
+    return findHalfedge( o, vt );
   };
 
 
@@ -111,6 +98,15 @@ public:
     return false;
   };
 
+  // total edge length of the closed loop
+  double length() {
+    double sum_length = .0;
+    const int n = (int) vertices().size();
+    for ( int i = 0; i < n; ++i )
+      sum_length += Eigen::Vector3d( vertex(i)->point() - vertex( (i + 1) % n )->point() ).norm();
+    return sum_length;
+  };
+
   // void optimize( int );
   void optimize( int n_corner ) {
     std::vector<double> arr_length;
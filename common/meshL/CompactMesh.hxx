@@ -0,0 +1,432 @@
+////////////////////////////////////////////////////////////////////
+//
+// Compact, index-based halfedge mesh (companion of MeshL).
+//
+// Elements are addressed by 32-bit handles and stored in contiguous
+// arrays.  Halfedges of face f occupy the range
+// [faceBegin(f), faceBegin(f) + faceSize(f)), so next()/prev() are
+// implicit.  While every face is a triangle no face offsets are stored
+// at all (face(h) = h / 3).
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _COMPACTMESH_HXX
+#define _COMPACTMESH_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "myEigen.hxx"
+
+#include "MeshL.hxx"
+
+class CompactMesh {
+
+ public:
+
+  using Index = int32_t;
+  static constexpr Index kInvalid = -1;
+
+  CompactMesh() { clear(); };
+  explicit CompactMesh(MeshL& mesh) { fromMeshL(mesh); };
+
+  void clear() {
+    points_.clear();
+    colors_.clear();
+    v_halfedge_.clear();
+    texcoords_.clear();
+    normals_.clear();
+    he_vertex_.clear();
+    he_mate_.clear();
+    he_texcoord_.clear();
+    he_normal_.clear();
+    he_face_.clear();
+    f_offset_.clear();
+    n_faces_ = 0;
+    is_triangle_ = true;
+    is_mates_ = false;
+  };
+
+  void reserve(Index nv, Index nf, Index nh) {
+    points_.reserve(nv);
+    v_halfedge_.reserve(nv);
+    he_vertex_.reserve(nh);
+    he_mate_.reserve(nh);
+    if (!is_triangle_) {
+      he_face_.reserve(nh);
+      f_offset_.reserve(nf + 1);
+    }
+  };
+
+  // sizes
+  Index numVertices() const { return (Index)points_.size(); };
+  Index numFaces() const { return n_faces_; };
+  Index numHalfedges() const { return (Index)he_vertex_.size(); };
+  Index numTexcoords() const { return (Index)texcoords_.size(); };
+  Index numNormals() const { return (Index)normals_.size(); };
+  bool isTriangleMesh() const { return is_triangle_; };
+  bool hasColors() const { return !colors_.empty(); };
+  bool hasTexcoords() const { return !he_texcoord_.empty(); };
+  bool hasNormals() const { return !he_normal_.empty(); };
+  bool isMates() const { return is_mates_; };
+
+  //
+  // vertices
+  //
+  Index addVertex(const Eigen::Vector3d& p) {
+    points_.push_back(p);
+    v_halfedge_.push_back(kInvalid);
+    if (!colors_.empty()) colors_.push_back(Eigen::Vector3d::Zero());
+    return numVertices() - 1;
+  };
+
+  Eigen::Vector3d& point(Index v) { return points_[v]; };
+  const Eigen::Vector3d& point(Index v) const { return points_[v]; };
+  std::vector<Eigen::Vector3d>& points() { return points_; };
+  const std::vector<Eigen::Vector3d>& points() const { return points_; };
+
+  // per-vertex color (allocated on first use)
+  const Eigen::Vector3d& color(Index v) const { return colors_[v]; };
+  void setColor(Index v, const Eigen::Vector3d& c) {
+    if (colors_.empty()) colors_.assign(points_.size(), Eigen::Vector3d::Zero());
+    colors_[v] = c;
+  };
+
+  // one of outgoing halfedges (boundary one if exists)
+  Index vertexHalfedge(Index v) const { return v_halfedge_[v]; };
+
+  //
+  // texcoords / normals (referred from halfedges)
+  //
+  Index addTexcoord(const Eigen::Vector3d& p) {
+    texcoords_.push_back(p);
+    return numTexcoords() - 1;
+  };
+  Eigen::Vector3d& texcoord(Index t) { return texcoords_[t]; };
+  const Eigen::Vector3d& texcoord(Index t) const { return texcoords_[t]; };
+
+  Index addNormal(const Eigen::Vector3d& p) {
+    normals_.push_back(p);
+    return numNormals() - 1;
+  };
+  Eigen::Vector3d& normal(Index n) { return normals_[n]; };
+  const Eigen::Vector3d& normal(Index n) const { return normals_[n]; };
+
+  //
+  // faces
+  //
+  // vids: vertex handles of the polygon (n >= 3)
+  // tids, nids: optional texcoord/normal handles per corner (kInvalid = none)
+  Index addFace(const Index* vids, int n, const Index* tids = nullptr,
+                const Index* nids = nullptr) {
+    if (n != 3 && is_triangle_) expandFaceOffsets();
+
+    const Index h0 = numHalfedges();
+    const Index f = n_faces_++;
+    for (int i = 0; i < n; ++i) {
+      he_vertex_.push_back(vids[i]);
+      he_mate_.push_back(kInvalid);
+      if (!is_triangle_) he_face_.push_back(f);
+    }
+    if (!is_triangle_) f_offset_.push_back(h0 + n);
+
+    if (tids != nullptr || !he_texcoord_.empty()) {
+      if (he_texcoord_.empty()) he_texcoord_.assign(h0, kInvalid);
+      for (int i = 0; i < n; ++i)
+        he_texcoord_.push_back(tids ? tids[i] : kInvalid);
+    }
+    if (nids != nullptr || !he_normal_.empty()) {
+      if (he_normal_.empty()) he_normal_.assign(h0, kInvalid);
+      for (int i = 0; i < n; ++i)
+        he_normal_.push_back(nids ? nids[i] : kInvalid);
+    }
+
+    is_mates_ = false;
+    return f;
+  };
+
+  Index addTriangle(Index v0, Index v1, Index v2) {
+    Index vids[3] = {v0, v1, v2};
+    return addFace(vids, 3);
+  };
+
+  Index faceBegin(Index f) const { return is_triangle_ ? 3 * f : f_offset_[f]; };
+  int faceSize(Index f) const {
+    return is_triangle_ ? 3 : (int)(f_offset_[f + 1] - f_offset_[f]);
+  };
+  Index faceHalfedge(Index f) const { return faceBegin(f); };
+
+  //
+  // halfedges
+  //
+  // origin vertex
+  Index vertex(Index h) const { return he_vertex_[h]; };
+  Index face(Index h) const { return is_triangle_ ? h / 3 : he_face_[h]; };
+  Index next(Index h) const {
+    if (is_triangle_) return (h % 3 == 2) ? h - 2 : h + 1;
+    const Index f = he_face_[h];
+    return (h + 1 == f_offset_[f + 1]) ? f_offset_[f] : h + 1;
+  };
+  Index prev(Index h) const {
+    if (is_triangle_) return (h % 3 == 0) ? h + 2 : h - 1;
+    const Index f = he_face_[h];
+    return (h == f_offset_[f]) ? f_offset_[f + 1] - 1 : h - 1;
+  };
+  Index nextVertex(Index h) const { return he_vertex_[next(h)]; };
+  Index mate(Index h) const { return he_mate_[h]; };
+  bool isBoundary(Index h) const { return he_mate_[h] == kInvalid; };
+  Index halfedgeTexcoord(Index h) const {
+    return he_texcoord_.empty() ? kInvalid : he_texcoord_[h];
+  };
+  Index halfedgeNormal(Index h) const {
+    return he_normal_.empty() ? kInvalid : he_normal_[h];
+  };
+
+  // raw arrays (for bulk algorithms)
+  const std::vector<Index>& halfedgeVertices() const { return he_vertex_; };
+  const std::vector<Index>& halfedgeMates() const { return he_mate_; };
+  std::vector<Index>& halfedgeMates() { return he_mate_; };
+
+  //
+  // connectivity
+  //
+  // Pairs halfedges by sorting packed (min, max) vertex keys.
+  // Returns the number of edges shared by more than two halfedges.
+  int buildMates() {
+    const Index nh = numHalfedges();
+    std::vector<std::pair<uint64_t, Index> > keys(nh);
+    for (Index h = 0; h < nh; ++h) {
+      keys[h] = std::make_pair(edgeKey(he_vertex_[h], nextVertex(h)), h);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::fill(he_mate_.begin(), he_mate_.end(), kInvalid);
+    int n_nonmanifold = 0;
+    size_t i = 0;
+    while (i < keys.size()) {
+      size_t j = i + 1;
+      while (j < keys.size() && keys[j].first == keys[i].first) ++j;
+      if (j - i > 2) ++n_nonmanifold;
+      // pair the first halfedge with the first one of opposite direction
+      const Index a = keys[i].second;
+      for (size_t k = i + 1; k < j; ++k) {
+        const Index b = keys[k].second;
+        if (he_vertex_[a] == nextVertex(b) && he_vertex_[b] == nextVertex(a)) {
+          he_mate_[a] = b;
+          he_mate_[b] = a;
+          break;
+        }
+      }
+      i = j;
+    }
+
+    buildVertexHalfedges();
+    is_mates_ = true;
+    return n_nonmanifold;
+  };
+
+  // assign an outgoing halfedge to each vertex; moves it to the boundary
+  // (same convention as HalfedgeL::reset())
+  void buildVertexHalfedges() {
+    std::fill(v_halfedge_.begin(), v_halfedge_.end(), kInvalid);
+    for (Index h = 0; h < numHalfedges(); ++h) v_halfedge_[he_vertex_[h]] = h;
+    for (Index v = 0; v < numVertices(); ++v) {
+      const Index start = v_halfedge_[v];
+      if (start == kInvalid) continue;
+      Index h = start;
+      while (he_mate_[h] != kInvalid) {
+        h = next(he_mate_[h]);
+        if (h == start) break;
+      }
+      v_halfedge_[v] = h;
+    }
+  };
+
+  static uint64_t edgeKey(Index a, Index b) {
+    const uint32_t lo = (uint32_t)std::min(a, b);
+    const uint32_t hi = (uint32_t)std::max(a, b);
+    return ((uint64_t)lo << 32) | (uint64_t)hi;
+  };
+
+  //
+  // conversion from/to MeshL
+  //
+  void fromMeshL(MeshL& mesh) {
+    clear();
+
+    std::unordered_map<const VertexL*, Index> vmap;
+    std::unordered_map<const TexcoordL*, Index> tmap;
+    std::unordered_map<const NormalL*, Index> nmap;
+    vmap.reserve(mesh.vertices().size());
+    points_.reserve(mesh.vertices().size());
+    v_halfedge_.reserve(mesh.vertices().size());
+    bool has_color = false;
+    for (auto& vt : mesh.vertices()) {
+      vmap[vt.get()] = addVertex(vt->point());
+      if (vt->hasColor()) has_color = true;
+    }
+    if (has_color) {
+      Index v = 0;
+      for (auto& vt : mesh.vertices()) {
+        if (vt->hasColor()) setColor(v, vt->color());
+        ++v;
+      }
+    }
+    for (auto& tc : mesh.texcoords()) tmap[tc.get()] = addTexcoord(tc->point());
+    for (auto& nm : mesh.normals()) nmap[nm.get()] = addNormal(nm->point());
+
+    const bool copy_mates = mesh.isConnectivity();
+    std::unordered_map<const HalfedgeL*, Index> hmap;
+    if (copy_mates) hmap.reserve(mesh.halfedges().size());
+    he_vertex_.reserve(mesh.halfedges().size());
+    he_mate_.reserve(mesh.halfedges().size());
+
+    std::vector<Index> vids, tids, nids;
+    size_t n_skipped = 0;
+    for (auto& fc : mesh.faces()) {
+      vids.clear(); tids.clear(); nids.clear();
+      bool has_t = false, has_n = false;
+      bool valid = true;
+      for (auto& he : fc->halfedges()) {
+        auto iv = vmap.find(he->vertexRaw());
+        if (iv == vmap.end()) {
+          valid = false;
+          break;
+        }
+        vids.push_back(iv->second);
+        Index t = kInvalid, n = kInvalid;
+        if (he->texcoord()) {
+          auto it = tmap.find(he->texcoord().get());
+          if (it != tmap.end()) { t = it->second; has_t = true; }
+        }
+        if (he->normal()) {
+          auto it = nmap.find(he->normal().get());
+          if (it != nmap.end()) { n = it->second; has_n = true; }
+        }
+        tids.push_back(t);
+        nids.push_back(n);
+      }
+      if (!valid) {
+        ++n_skipped;
+        continue;
+      }
+      if (vids.size() < 3) continue;
+      // halfedges of accepted faces only
+      if (copy_mates) {
+        Index h = numHalfedges();
+        for (auto& he : fc->halfedges()) hmap[he.get()] = h++;
+      }
+      addFace(vids.data(), (int)vids.size(),
+              has_t ? tids.data() : nullptr, has_n ? nids.data() : nullptr);
+    }
+    if (n_skipped)
+      std::cerr << "Halfedge vertex not in the mesh: " << n_skipped << " faces skipped" << std::endl;
+
+    if (copy_mates) {
+      for (auto& fc : mesh.faces()) {
+        for (auto& he : fc->halfedges()) {
+          if (!he->mate()) continue;
+          auto a = hmap.find(he.get());
+          auto b = hmap.find(he->mate().get());
+          if (a != hmap.end() && b != hmap.end()) he_mate_[a->second] = b->second;
+        }
+      }
+      buildVertexHalfedges();
+      is_mates_ = true;
+    }
+  };
+
+  // mesh is cleared.  Mates are transferred directly when available,
+  // otherwise built here if isCreateConnectivity is true.
+  void toMeshL(MeshL& mesh, bool isCreateConnectivity = true) {
+    mesh.deleteAll();
+    if (isCreateConnectivity && !is_mates_) buildMates();
+
+    std::vector<std::shared_ptr<VertexL> > vts(numVertices());
+    for (Index v = 0; v < numVertices(); ++v) {
+      vts[v] = mesh.addVertex(points_[v]);
+      if (hasColors()) vts[v]->setColor(colors_[v]);
+    }
+    std::vector<std::shared_ptr<TexcoordL> > tcs(numTexcoords());
+    for (Index t = 0; t < numTexcoords(); ++t) tcs[t] = mesh.addTexcoord(texcoords_[t]);
+    std::vector<std::shared_ptr<NormalL> > nms(numNormals());
+    for (Index n = 0; n < numNormals(); ++n) nms[n] = mesh.addNormal(normals_[n]);
+
+    std::vector<std::shared_ptr<HalfedgeL> > hes(numHalfedges());
+    for (Index f = 0; f < numFaces(); ++f) {
+      std::shared_ptr<FaceL> fc = mesh.addFace();
+      const Index h0 = faceBegin(f);
+      const int n = faceSize(f);
+      for (int i = 0; i < n; ++i) {
+        const Index h = h0 + i;
+        const Index t = halfedgeTexcoord(h);
+        const Index nm = halfedgeNormal(h);
+        hes[h] = mesh.addHalfedge(fc, vts[he_vertex_[h]],
+                                  (nm != kInvalid) ? nms[nm] : nullptr,
+                                  (t != kInvalid) ? tcs[t] : nullptr);
+      }
+      fc->calcNormal();
+    }
+
+    if (is_mates_) {
+      for (Index h = 0; h < numHalfedges(); ++h) {
+        if (he_mate_[h] != kInvalid) hes[h]->setMate(hes[he_mate_[h]]);
+      }
+      for (Index v = 0; v < numVertices(); ++v) {
+        if (v_halfedge_[v] != kInvalid) vts[v]->setHalfedge(hes[v_halfedge_[v]]);
+      }
+      mesh.setConnectivity(true);
+    }
+  };
+
+ private:
+
+  // shares the arrays chunk-wise
+  friend class MeshSnapshotL;
+  // fills the arrays from a mesh cache
+  friend class MeshCacheLIO;
+
+  // switch from the triangle fast path to explicit face offsets
+  void expandFaceOffsets() {
+    is_triangle_ = false;
+    f_offset_.resize(n_faces_ + 1);
+    for (Index f = 0; f <= n_faces_; ++f) f_offset_[f] = 3 * f;
+    he_face_.resize(he_vertex_.size());
+    for (Index h = 0; h < numHalfedges(); ++h) he_face_[h] = h / 3;
+  };
+
+  // vertices
+  std::vector<Eigen::Vector3d> points_;
+  std::vector<Eigen::Vector3d> colors_;
+  std::vector<Index> v_halfedge_;
+
+  // texcoords, normals
+  std::vector<Eigen::Vector3d> texcoords_;
+  std::vector<Eigen::Vector3d> normals_;
+
+  // halfedges
+  std::vector<Index> he_vertex_;
+  std::vector<Index> he_mate_;
+  std::vector<Index> he_texcoord_;
+  std::vector<Index> he_normal_;
+  std::vector<Index> he_face_;   // empty while triangle-only
+
+  // faces
+  std::vector<Index> f_offset_;  // empty while triangle-only
+  Index n_faces_;
+  bool is_triangle_;
+
+  bool is_mates_;
+};
+
+#endif // _COMPACTMESH_HXX
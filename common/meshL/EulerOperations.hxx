@@ -14,13 +14,94 @@
 #include "mydef.h"
 #include "myEigen.hxx"
 #include "MeshL.hxx"
+#include "MeshTransactionL.hxx"
+#include "MeshValidatorL.hxx"
+#include <functional>
 #include <map>
+#include <memory>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 class EulerOperations {
  public:
   // Constructor
   EulerOperations(std::shared_ptr<MeshL> mesh) : mesh_(mesh) {}
+  ~EulerOperations() {
+    if (transaction_ && mesh_ && mesh_->editLog() == transaction_.get())
+      mesh_->setEditLog(nullptr);
+  }
+
+  // ============================================================================
+  // Transactions (undo / redo)
+  // ============================================================================
+  //
+  // Operations between beginTransaction() and commitTransaction() are
+  // logged in a MeshTransactionL: each element they change is saved the
+  // first time it is touched.  rollbackTransaction(), undo() and redo()
+  // take time proportional to the number of changed elements, not to
+  // the mesh size.  Editing the mesh by other means between
+  // transactions clears the history.
+
+  bool beginTransaction() {
+    if (!mesh_ || transaction_ || mesh_->editLog()) return false;
+    if (!historyValid()) clearHistory();
+    transaction_.reset(new MeshTransactionL(mesh_.get()));
+    mesh_->setEditLog(transaction_.get());
+    return true;
+  }
+
+  bool commitTransaction() {
+    if (!transaction_) return false;
+    mesh_->setEditLog(nullptr);
+    transaction_->close();
+    if (!transaction_->empty()) {
+      undo_.push_back(std::move(transaction_));
+      redo_.clear();
+    }
+    transaction_.reset();
+    history_version_ = mesh_->topologyVersion();
+    return true;
+  }
+
+  bool rollbackTransaction() {
+    if (!transaction_) return false;
+    mesh_->setEditLog(nullptr);
+    transaction_->close();
+    transaction_->undo();
+    transaction_.reset();
+    history_version_ = mesh_->topologyVersion();
+    return true;
+  }
+
+  bool isInTransaction() const { return transaction_ != nullptr; }
+
+  bool canUndo() const { return !transaction_ && !undo_.empty() && historyValid(); }
+  bool canRedo() const { return !transaction_ && !redo_.empty() && historyValid(); }
+
+  // the last committed transaction
+  bool undo() {
+    if (!canUndo()) return false;
+    undo_.back()->undo();
+    redo_.push_back(std::move(undo_.back()));
+    undo_.pop_back();
+    history_version_ = mesh_->topologyVersion();
+    return true;
+  }
+
+  bool redo() {
+    if (!canRedo()) return false;
+    redo_.back()->redo();
+    undo_.push_back(std::move(redo_.back()));
+    redo_.pop_back();
+    history_version_ = mesh_->topologyVersion();
+    return true;
+  }
+
+  void clearHistory() {
+    undo_.clear();
+    redo_.clear();
+  }
 
   // ============================================================================
   // Rigorous Half-edge Connectivity Management
@@ -29,6 +110,8 @@ class EulerOperations {
   // Helper function to properly set mate relationships
   void setMate(std::shared_ptr<HalfedgeL> he1, std::shared_ptr<HalfedgeL> he2) {
     if (he1 && he2) {
+      touch(he1);
+      touch(he2);
       he1->setMate(he2);
       he2->setMate(he1);
     }
@@ -38,6 +121,7 @@ class EulerOperations {
   void updateVertexHalfedge(std::shared_ptr<VertexL> vertex,
                             std::shared_ptr<HalfedgeL> he) {
     if (vertex && he) {
+      touch(vertex);
       vertex->setHalfedge(he);
     }
   }
@@ -53,6 +137,7 @@ class EulerOperations {
         for (auto face : mesh->faces()) {
           for (auto he : face->halfedges()) {
             if (he->vertex() == vertex) {
+              if (mesh->editLog()) mesh->editLog()->touch(vertex);
               vertex->setHalfedge(he);
               found = true;
               break;
@@ -65,66 +150,113 @@ class EulerOperations {
   }
 
   // Update all mate relationships (preserving existing mates)
+  //
+  // Existing mates whose halfedge is still in a face are kept; the others
+  // are paired with the first unmatched halfedge (in face order) of
+  // another face on the same vertex pair.  O(H) with an edge-keyed hash.
   void updateAllMates() {
     if (!mesh_) return;
-    
+
+    // every halfedge in a face, in face order
+    std::vector<std::shared_ptr<HalfedgeL>> hes;
+    for (auto& face : mesh_->faces())
+      for (auto& he : face->halfedges()) hes.push_back(he);
+
     // First, preserve existing mate relationships that are still valid
-    std::map<int, int> preserved_mates;
-    for (auto face : mesh_->faces()) {
-      for (auto he : face->halfedges()) {
-        if (he->mate()) {
-          preserved_mates[he->id()] = he->mate()->id();
-        }
+    std::unordered_map<int, int> preserved_mates;
+    for (auto& he : hes)
+      if (he->mate()) preserved_mates[he->id()] = he->mate()->id();
+
+    // the first halfedge with a given id
+    std::unordered_map<int, std::shared_ptr<HalfedgeL>> by_id;
+    by_id.reserve(hes.size());
+    for (auto& he : hes) by_id.emplace(he->id(), he);
+
+    // Clear all existing mate relationships
+    if (mesh_->editLog())
+      for (auto& he : hes) touch(he);
+    for (auto& he : hes) he->setMate(nullptr);
+
+    // Restore preserved mate relationships
+    for (auto& he : hes) {
+      auto it = preserved_mates.find(he->id());
+      if (it == preserved_mates.end()) continue;
+      auto he2 = by_id.find(it->second);
+      if (he2 == by_id.end()) continue;
+      he->setMate(he2->second);
+      he2->second->setMate(he);
+    }
+
+    // Find and set new mate relationships for unmatched halfedges
+    EdgeMap edges;
+    edges.reserve(hes.size());
+    for (auto& he : hes) edges[edgeKey(he)].push_back(he);
+    for (auto& he1 : hes) {
+      if (he1->mate()) continue;
+      for (auto& he2 : edges[edgeKey(he1)]) {
+        if (he2->face() == he1->face() || he2->mate()) continue;
+        he1->setMate(he2);
+        he2->setMate(he1);
+        break;
       }
     }
-    
-    // Clear all existing mate relationships
-    for (auto face : mesh_->faces()) {
-      for (auto he : face->halfedges()) {
+    open_valid_ = false;
+  }
+
+  // Update mates around faces an operation changed
+  //
+  // Halfedges of faces (and the halfedges in ring, e.g. former mates of
+  // a deleted face) drop mates that left the mesh and are paired with
+  // unmatched halfedges on the same vertex pair.  Only the changed
+  // region is visited: partners elsewhere are found in the table of
+  // unmatched halfedges.
+  void updateMates(const std::vector<std::shared_ptr<FaceL>>& faces,
+                   const std::vector<std::shared_ptr<HalfedgeL>>& ring = {}) {
+    if (!mesh_) return;
+    if (!open_valid_) rebuildOpenHalfedges();
+
+    std::vector<std::shared_ptr<HalfedgeL>> hes;
+    std::set<HalfedgeL*> seen;
+    for (auto& face : faces) {
+      if (!face) continue;
+      for (auto& he : face->halfedges())
+        if (seen.insert(he.get()).second) hes.push_back(he);
+    }
+    for (auto& he : ring)
+      if (isInFace(he) && seen.insert(he.get()).second) hes.push_back(he);
+
+    // keep mates that are still in the mesh
+    for (auto& he : hes) {
+      auto mate = he->mate();
+      if (!mate) continue;
+      touch(he);
+      touch(mate);
+      if (isInFace(mate)) {
+        mate->setMate(he);
+      } else {
         he->setMate(nullptr);
       }
     }
-    
-    // Restore preserved mate relationships
-    for (auto face : mesh_->faces()) {
-      for (auto he : face->halfedges()) {
-        auto it = preserved_mates.find(he->id());
-        if (it != preserved_mates.end()) {
-          // Find the mate halfedge
-          for (auto face2 : mesh_->faces()) {
-            for (auto he2 : face2->halfedges()) {
-              if (he2->id() == it->second) {
-                he->setMate(he2);
-                he2->setMate(he);
-                break;
-              }
-            }
-          }
-        }
-      }
+    for (auto& he : hes)
+      if (!he->mate()) open_[edgeKey(he)].push_back(he);
+
+    // pair the others
+    for (auto& he1 : hes) {
+      if (he1->mate()) continue;
+      auto partner = findOpenMate(he1);
+      if (partner) setMate(he1, partner);
     }
-    
-    // Find and set new mate relationships for unmatched halfedges
-    for (auto face1 : mesh_->faces()) {
-      for (auto he1 : face1->halfedges()) {
-        if (he1->mate()) continue; // Already has mate
-        auto v1 = he1->vertex();
-        auto v2 = he1->next()->vertex();
-        
-        // Look for mate in other faces
-        for (auto face2 : mesh_->faces()) {
-          if (face1 == face2) continue;
-          for (auto he2 : face2->halfedges()) {
-            if (he2->mate()) continue;
-            auto v2_he2 = he2->vertex();
-            auto v1_he2 = he2->next()->vertex();
-            if ((v1 == v2_he2 && v2 == v1_he2) || (v1 == v1_he2 && v2 == v2_he2)) {
-              he1->setMate(he2);
-              he2->setMate(he1);
-              break;
-            }
-          }
-          if (he1->mate()) break;
+  }
+
+  // Update vertex halfedge pointers of the vertices of faces
+  void ensureVertexHalfedges(const std::vector<std::shared_ptr<FaceL>>& faces) {
+    for (auto& face : faces) {
+      if (!face) continue;
+      for (auto& he : face->halfedges()) {
+        auto vertex = he->vertex();
+        if (vertex && !vertex->halfedge()) {
+          touch(vertex);
+          vertex->setHalfedge(he);
         }
       }
     }
@@ -148,6 +280,9 @@ class EulerOperations {
       }
     }
     
+    if (mesh_) mesh_->touchTopology();
+    touchFace(mesh_, face);
+    for (auto& he : halfedges) touch(he);
     face->deleteHalfedges();
     std::set<int> seen;
     for (auto& he : halfedges) {
@@ -217,15 +352,35 @@ class EulerOperations {
       return nullptr;
     }
 
+    auto newVertex = splitInternalEdge(mesh, he1, newPos);
+    if (!newVertex) return nullptr;
+
+    // Update vertex halfedge pointers
+    EulerOperations temp_euler(mesh);
+    temp_euler.ensureVertexHalfedges(mesh);
+
+    return newVertex;
+  }
+
+  // MEV body of makeEdgeVertexOpenMesh: split the edge of he1 and its mate
+  static std::shared_ptr<VertexL> splitInternalEdge(
+      std::shared_ptr<MeshL> mesh,
+      std::shared_ptr<HalfedgeL> he1,
+      const Eigen::Vector3d& newPos) {
+    auto he2 = he1->mate();
+    auto v1 = he1->vertex();
+    auto v2 = he2->vertex();
+
     // Check for self-loop edge (same face on both sides)
     if (he1->face() == he2->face()) {
       return nullptr;
     }
+    touchFace(mesh, he1->face());
+    touchFace(mesh, he2->face());
 
     // Create new vertex
     Eigen::Vector3d pos_copy = newPos;  // Create non-const copy
     auto newVertex = mesh->addVertex(pos_copy);
-    newVertex->setID(mesh->vertices().size() - 1);
 
     // Create new halfedges for the split internal edge
     auto he1_new = mesh->addHalfedge(he1->face(), v1);
@@ -293,11 +448,8 @@ class EulerOperations {
     temp_euler.rebuildFaceHalfedges(face2, face2_halfedges);
 
     // Update vertex halfedge pointers
-    temp_euler.ensureVertexHalfedges(mesh);
-    EulerOperations temp_euler2(mesh);
-    temp_euler2.ensureVertexHalfedges(mesh);
+    temp_euler.ensureVertexHalfedges({face1, face2});
 
-    
     return newVertex;
   }
 
@@ -337,6 +489,7 @@ class EulerOperations {
     if (!targetFace) {
       return nullptr;
     }
+    touchFace(mesh, targetFace);
 
     // Find indices of he_v1 and he_v2 in the face
     int idx_v1 = -1, idx_v2 = -1;
@@ -350,7 +503,6 @@ class EulerOperations {
 
     // Create new face
     auto newFace = mesh->addFace();
-    newFace->setID(mesh->faces().size() - 1);
 
     // Create new halfedges for the edge
     auto he1 = mesh->addHalfedge(targetFace, v1);
@@ -419,6 +571,7 @@ class EulerOperations {
   std::shared_ptr<VertexL> makeEdgeVertex(std::shared_ptr<HalfedgeL> edge_halfedge,
                                           const Eigen::Vector3d& new_pos) {
     if (!mesh_ || !edge_halfedge) return nullptr;
+    LocalEdit edit(this);
 
     auto v1 = edge_halfedge->vertex();
     auto v2 = edge_halfedge->next()->vertex();
@@ -426,12 +579,12 @@ class EulerOperations {
 
     auto face = edge_halfedge->face();
     if (!face) return nullptr;
+    touchFace(mesh_, face);
 
 
     // Create new vertex
     Eigen::Vector3d pos_copy = new_pos;  // Create non-const copy
     auto newVertex = mesh_->addVertex(pos_copy);
-    newVertex->setID(mesh_->vertices().size() - 1);
 
     // Create new halfedges for the split edge
     auto he1 = mesh_->addHalfedge(face, v1);
@@ -451,9 +604,15 @@ class EulerOperations {
 
     rebuildFaceHalfedges(face, new_halfedges);
 
+    // the new halfedges are unmatched (boundary)
+    if (open_valid_) {
+      open_[edgeKey(he1)].push_back(he1);
+      open_[edgeKey(he2)].push_back(he2);
+    }
+
     // Update vertex halfedge pointers
     updateVertexHalfedge(newVertex, he2);
-    ensureVertexHalfedges(mesh_);
+    ensureVertexHalfedges({face});
 
     return newVertex;
   }
@@ -462,6 +621,7 @@ class EulerOperations {
   std::shared_ptr<VertexL> splitEdgeMakeVertex(std::shared_ptr<HalfedgeL> edge_halfedge,
                                                const Eigen::Vector3d& new_pos) {
     if (!mesh_ || !edge_halfedge) return nullptr;
+    LocalEdit edit(this);
 
     auto v1 = edge_halfedge->vertex();
     auto v2 = edge_halfedge->next()->vertex();
@@ -470,9 +630,18 @@ class EulerOperations {
     auto mate_halfedge = edge_halfedge->mate();
     auto face1 = edge_halfedge->face();
     auto face2 = mate_halfedge ? mate_halfedge->face() : nullptr;
+    touchFace(mesh_, face1);
+    touchFace(mesh_, face2);
 
     // Step 1: Adding new vertex with MEV...
-    auto newVertex = EulerOperations::makeEdgeVertexOpenMesh(mesh_, v1, v2, new_pos);
+    // (the edge itself if it is v1->v2 with a mate, otherwise the first
+    // such edge in the mesh)
+    std::shared_ptr<VertexL> newVertex = nullptr;
+    if (mate_halfedge && mate_halfedge->vertex() == v2) {
+      newVertex = splitInternalEdge(mesh_, edge_halfedge, new_pos);
+    } else {
+      newVertex = EulerOperations::makeEdgeVertexOpenMesh(mesh_, v1, v2, new_pos);
+    }
     if (!newVertex) {
       return nullptr;
     }
@@ -509,11 +678,11 @@ class EulerOperations {
     }
 
     // mate関係を厳密に張る
-    updateAllMates();
+    updateMates({face1, face2});
 
     // 頂点のhalfedgeをセット
     updateVertexHalfedge(newVertex, nullptr);
-    ensureVertexHalfedges(mesh_);
+    ensureVertexHalfedges({face1, face2});
 
     return newVertex;
   }
@@ -521,6 +690,7 @@ class EulerOperations {
   // OpenMesh-style MEF: Split a face by inserting an edge between two halfedges
   std::shared_ptr<FaceL> makeEdgeFace(std::shared_ptr<HalfedgeL> he_v1, std::shared_ptr<HalfedgeL> he_v2) {
     if (!mesh_ || !he_v1 || !he_v2) return nullptr;
+    LocalEdit edit(this);
     auto f = he_v1->face();
     if (!f || he_v1->vertex() == he_v2->vertex()) return nullptr;
 
@@ -546,6 +716,7 @@ class EulerOperations {
     if (idx_v1 == -1 || idx_v2 == -1) {
       return nullptr;
     }
+    touchFace(mesh_, f);
     
 
     // path1: he_v1->next() から he_v2 まで（he_v1, he_v2は含めない）
@@ -643,7 +814,7 @@ class EulerOperations {
     // --- ここまで追加 ---
 
     // Update vertex halfedge pointers
-    ensureVertexHalfedges(mesh_);
+    ensureVertexHalfedges({f, f_new});
     
     // Verify mate relationship for the new edge (after ensureVertexHalfedges)
     if (he1->mate() != he2 || he2->mate() != he1) {
@@ -660,6 +831,7 @@ class EulerOperations {
   // 3. Kill Edge Make Ring (KEMR) - Remove an edge and merge two faces
   bool killEdgeMakeRing(std::shared_ptr<HalfedgeL> he) {
     if (!mesh_ || !he) return false;
+    LocalEdit edit(this);
 
     auto mate = he->mate();
     if (!mate) return false;  // Boundary edge
@@ -690,14 +862,7 @@ class EulerOperations {
     }
     
     // エッジが実際にメッシュに存在するかチェック
-    bool he_found = false, mate_found = false;
-    for (auto face : mesh_->faces()) {
-      for (auto he_face : face->halfedges()) {
-        if (he_face == he) he_found = true;
-        if (he_face == mate) mate_found = true;
-      }
-    }
-    if (!he_found || !mate_found) {
+    if (!isInFace(he) || !isInFace(mate)) {
       return false;
     }
     
@@ -711,6 +876,8 @@ class EulerOperations {
       return false;
     }
     // --- ここまで修正された安全チェック ---
+    touchFace(mesh_, face1);
+    touchFace(mesh_, face2);
 
     // Get the vertices
     auto v1 = he->vertex();
@@ -791,18 +958,16 @@ class EulerOperations {
 
     // --- 修正された後処理 ---
     // 7. mate関係を更新
-    updateAllMates();
+    updateMates({face1});
     
-    // 8. すべてのvertex halfedgeを確実に更新
-    ensureVertexHalfedges(mesh_);
+    // 8. 統合したfaceのvertex halfedgeを更新
+    ensureVertexHalfedges({face1});
     
     // 9. 最終的なmate関係の検証
     bool mate_relationships_valid = true;
-    for (auto face : mesh_->faces()) {
-      for (auto he_face : face->halfedges()) {
-        if (he_face->mate() && he_face->mate()->mate() != he_face) {
-          mate_relationships_valid = false;
-        }
+    for (auto he_face : face1->halfedges()) {
+      if (he_face->mate() && he_face->mate()->mate() != he_face) {
+        mate_relationships_valid = false;
       }
     }
     
@@ -820,6 +985,7 @@ class EulerOperations {
                                               std::shared_ptr<VertexL> v2,
                                               std::shared_ptr<FaceL> face) {
     if (!mesh_ || !v1 || !v2 || !face || v1 == v2) return nullptr;
+    LocalEdit edit(this);
 
     // Check if vertices are in the face
     bool v1_in_face = false, v2_in_face = false;
@@ -837,6 +1003,7 @@ class EulerOperations {
     }
 
     if (!v1_in_face || !v2_in_face || !he_v1 || !he_v2) return nullptr;
+    touchFace(mesh_, face);
 
     // Create new face
     auto new_face = mesh_->addFace();
@@ -878,9 +1045,9 @@ class EulerOperations {
     face2_halfedges.insert(face2_halfedges.end(), path2.begin(), path2.end());
     rebuildFaceHalfedges(new_face, face2_halfedges);
 
-    updateAllMates();
+    updateMates({face, new_face});
     // Update vertex halfedges if needed
-    ensureVertexHalfedges(mesh_);
+    ensureVertexHalfedges({face, new_face});
 
     return he_new1;
   }
@@ -888,11 +1055,13 @@ class EulerOperations {
   // 5. Kill Face Make Ring Hole (KFMRH) - Remove a face to create a hole
   bool killFaceMakeRingHole(std::shared_ptr<FaceL> face) {
     if (!mesh_ || !face) return false;
+    LocalEdit edit(this);
 
 
     // Check if face is a simple polygon (no holes)
     auto halfedges = face->halfedges();
     if (halfedges.empty()) return false;
+    touchFace(mesh_, face);
 
     // Update vertex halfedges if they point to this face
     for (auto he : halfedges) {
@@ -906,12 +1075,21 @@ class EulerOperations {
       }
     }
 
+    // halfedges across the face (they become boundary)
+    std::vector<std::shared_ptr<HalfedgeL>> ring;
+    std::vector<std::shared_ptr<FaceL>> ring_faces;
+    for (auto he : halfedges) {
+      if (!he->mate()) continue;
+      ring.push_back(he->mate());
+      ring_faces.push_back(he->mate()->face());
+    }
+
     // Remove the face
     mesh_->deleteFace(face);
 
-    updateAllMates();
-    // Ensure all vertices have halfedge pointers
-    ensureVertexHalfedges(mesh_);
+    updateMates({}, ring);
+    // Ensure the vertices around have halfedge pointers
+    ensureVertexHalfedges(ring_faces);
 
 
     return true;
@@ -921,6 +1099,7 @@ class EulerOperations {
   std::shared_ptr<FaceL> makeFaceKillRingHole(
       std::vector<std::shared_ptr<VertexL>> vertices) {
     if (!mesh_ || vertices.size() < 3) return nullptr;
+    LocalEdit edit(this);
 
     // Create new face
     auto face = mesh_->addFace();
@@ -936,7 +1115,7 @@ class EulerOperations {
     // Rebuild face's halfedge list
     rebuildFaceHalfedges(face, halfedges);
 
-    updateAllMates();
+    updateMates({face});
     // Update vertex halfedges if needed
     for (auto he : halfedges) {
       auto vertex = he->vertex();
@@ -946,7 +1125,7 @@ class EulerOperations {
     }
 
     // Ensure all vertices have halfedge pointers
-    ensureVertexHalfedges(mesh_);
+    ensureVertexHalfedges({face});
 
     return face;
   }
@@ -958,6 +1137,7 @@ class EulerOperations {
   // Kill Edge Vertex (KEV) - Remove a vertex by merging its incident edges
   bool killEdgeVertex(std::shared_ptr<VertexL> vertex) {
     if (!mesh_ || !vertex) return false;
+    LocalEdit edit(this);
 
     // Find a halfedge that points to this vertex
     std::shared_ptr<HalfedgeL> he = nullptr;
@@ -988,6 +1168,8 @@ class EulerOperations {
     // Get the faces
     auto face1 = he->face();
     auto face2 = mate->face();
+    touchFace(mesh_, face1);
+    touchFace(mesh_, face2);
 
     // Get the halfedges around the vertex
     auto he_prev = he->prev();
@@ -1024,17 +1206,6 @@ class EulerOperations {
     mate->setFace(nullptr);
     mate->setVertex(nullptr);
     
-    // 削除前に、このhalfedgeを参照している他の要素の参照もクリア
-    for (auto fc : mesh_->faces()) {
-      for (auto he_face : fc->halfedges()) {
-        if (he_face == he || he_face == mate) {
-          he_face->setMate(nullptr);
-          he_face->setFace(nullptr);
-          he_face->setVertex(nullptr);
-        }
-      }
-    }
-    
     // meshからhalfedgeを削除
     mesh_->deleteHalfedge(he);
     mesh_->deleteHalfedge(mate);
@@ -1052,7 +1223,7 @@ class EulerOperations {
     for (auto& h : face2_halfedges) if (seen.insert(h->id()).second) merged_halfedges.push_back(h);
     rebuildFaceHalfedges(face1, merged_halfedges);
 
-    updateAllMates();
+    updateMates({face1});
     // Update vertex halfedges if needed
     if (v1->halfedge() == he) updateVertexHalfedge(v1, he_next);
     if (v2->halfedge() == mate) updateVertexHalfedge(v2, mate_next);
@@ -1064,23 +1235,23 @@ class EulerOperations {
     mesh_->deleteVertex(vertex);
 
     // --- ここから修正: 削除後の完全なリスト再構築 ---
-    // 削除後にface/vertex/halfedgeリストを完全に再構築
-    for (auto fc : mesh_->faces()) {
+    // 削除後にface1のhalfedgeリストを再構築（他のfaceは変更されない）
+    {
       std::vector<std::shared_ptr<HalfedgeL>> valid_halfedges;
-      for (auto he_face : fc->halfedges()) {
+      for (auto he_face : face1->halfedges()) {
         if (he_face && he_face->vertex() && he_face->face()) {
           valid_halfedges.push_back(he_face);
         }
       }
-      fc->deleteHalfedges();
+      face1->deleteHalfedges();
       for (auto he_face : valid_halfedges) {
-        fc->addHalfedge(he_face);
+        face1->addHalfedge(he_face);
       }
     }
     // --- ここまで修正 ---
 
-    // Ensure all vertices have halfedge pointers
-    ensureVertexHalfedges(mesh_);
+    // Ensure the merged face's vertices have halfedge pointers
+    ensureVertexHalfedges({face1});
 
     return true;
   }
@@ -1107,6 +1278,8 @@ class EulerOperations {
     if (he1->face() == he2->face()) {
       return false;
     }
+    touchFace(mesh, he1->face());
+    touchFace(mesh, he2->face());
     
     // --- 削除前に他要素の参照をクリア ---
     he1->setMate(nullptr);
@@ -1173,6 +1346,8 @@ class EulerOperations {
     if (he1->face() == he2->face()) {
       return false;
     }
+    touchFace(mesh, he1->face());
+    touchFace(mesh, he2->face());
     // --- 削除前に他要素の参照をクリア ---
     he1->setMate(nullptr);
     he2->setMate(nullptr);
@@ -1273,156 +1448,31 @@ class EulerOperations {
   // ============================================================================
 
   // Validate mesh connectivity
+  // (Euler characteristic 0, 1 or 2; see MeshValidatorL for the details)
   bool validateMesh() const {
     if (!mesh_) return false;
+    const MeshValidationReport r = validationReport();
 
     // Simple validation: check if mesh has basic structure
-    if (mesh_->vertices_size() == 0) {
-      return false;
-    }
-
-    if (mesh_->faces_size() == 0) {
-      return false;
-    }
+    if (r.n_vertices == 0 || r.n_faces == 0) return false;
 
     // Check if all faces have halfedges
-    for (auto face : mesh_->faces()) {
-      if (face->halfedges().empty()) {
-        return false;
-      }
-    }
+    if (r.n_empty_faces > 0) return false;
 
     // 最終的なEuler characteristic計算
-    int V = mesh_->vertices_size();
-    int E = countUniqueEdges();
-    int F = mesh_->faces_size();
-    int euler_char = V - E + F;
-
-    // Debug: print face details
-    for (auto face : mesh_->faces()) {
-      for (auto he : face->halfedges()) {
-      }
-    }
-
-    if (euler_char == 2) {
-    } else if (euler_char == 1) {
-    } else if (euler_char == 0) {
-    } else {
-      // 詳細デバッグ出力
-      for (auto v : mesh_->vertices()) {
-      }
-      for (auto f : mesh_->faces()) {
-        for (auto he : f->halfedges()) {
-        }
-      }
-      for (auto f : mesh_->faces()) {
-        for (auto he : f->halfedges()) {
-        }
-      }
-    }
-
-    // 参照整合性チェック
-    bool valid = true;
-    std::set<int> valid_vertex_ids, valid_face_ids;
-    for (auto v : mesh_->vertices()) valid_vertex_ids.insert(v->id());
-    for (auto f : mesh_->faces()) valid_face_ids.insert(f->id());
-
-    // 頂点のhalfedge参照チェック
-    for (auto v : mesh_->vertices()) {
-      auto he = v->halfedge();
-      if (he) {
-        if (!he->vertex() || valid_vertex_ids.find(he->vertex()->id()) == valid_vertex_ids.end()) {
-          valid = false;
-        }
-        if (!he->face() || valid_face_ids.find(he->face()->id()) == valid_face_ids.end()) {
-          valid = false;
-        }
-      }
-    }
-    // faceのhalfedgeリスト参照チェック
-    for (auto f : mesh_->faces()) {
-      for (auto he : f->halfedges()) {
-        if (!he->vertex() || valid_vertex_ids.find(he->vertex()->id()) == valid_vertex_ids.end()) {
-          valid = false;
-        }
-        if (!he->face() || valid_face_ids.find(he->face()->id()) == valid_face_ids.end()) {
-          valid = false;
-        }
-      }
-    }
-    // mate参照チェック
-    for (auto f : mesh_->faces()) {
-      for (auto he : f->halfedges()) {
-        if (he->mate()) {
-          if (!he->mate()->vertex() || valid_vertex_ids.find(he->mate()->vertex()->id()) == valid_vertex_ids.end()) {
-            valid = false;
-          }
-          if (!he->mate()->face() || valid_face_ids.find(he->mate()->face()->id()) == valid_face_ids.end()) {
-            valid = false;
-          }
-        }
-      }
-    }
-    if (!valid) {
-    }
-
+    const int euler_char = r.euler_characteristic;
     return (euler_char == 2 || euler_char == 1 || euler_char == 0);
   }
 
-  // Count unique edges in the mesh (corrected for boundary edges)
+  // Full consistency report (mates, cycles, vertex halfedges, manifoldness)
+  MeshValidationReport validationReport() const {
+    return MeshValidatorL(mesh_).validate();
+  }
+
+  // Count unique edges in the mesh (distinct vertex pairs)
   int countUniqueEdges() const {
     if (!mesh_) return 0;
-    std::set<std::pair<int, int>> edge_set;
-    int boundary_edges = 0;
-    int internal_edges = 0;
-    
-    // --- ここから修正: より正確なエッジカウントロジック ---
-    // 全てのhalfedgeを走査してエッジをカウント
-    std::set<int> processed_halfedges;
-    
-    for (auto face : mesh_->faces()) {
-      if (!face) continue;
-      
-      for (auto he : face->halfedges()) {
-        if (!he || !he->vertex() || !he->next() || !he->next()->vertex()) {
-          continue;
-        }
-        
-        // 既に処理済みのhalfedgeはスキップ
-        if (processed_halfedges.find(he->id()) != processed_halfedges.end()) {
-          continue;
-        }
-        
-        int v1 = he->vertex()->id();
-        int v2 = he->next()->vertex()->id();
-        
-        // 常に小さいIDをv1、大きいIDをv2にする（重複カウント防止）
-        if (v1 > v2) std::swap(v1, v2);
-        
-        auto edge_pair = std::make_pair(v1, v2);
-        if (edge_set.find(edge_pair) == edge_set.end()) {
-          edge_set.insert(edge_pair);
-          
-          // このhalfedgeとそのmateを処理済みとしてマーク
-          processed_halfedges.insert(he->id());
-          if (he->mate()) {
-            processed_halfedges.insert(he->mate()->id());
-          }
-          
-          // Check if this is a boundary edge (no mate) or internal edge (has mate)
-          if (he->mate() && he->mate()->face() && he->face() && 
-              he->mate()->face()->id() != he->face()->id()) {
-            internal_edges++;
-          } else {
-            boundary_edges++;
-          }
-        }
-      }
-    }
-    // --- ここまで修正 ---
-    
-    
-    return internal_edges + boundary_edges;
+    return validationReport().n_edges;
   }
 
   // ============================================================================
@@ -1547,15 +1597,7 @@ class EulerOperations {
     }
     
     // Check if the edge is still valid in the mesh
-    bool he_found = false, mate_found = false;
-    for (auto face : mesh_->faces()) {
-      for (auto he_face : face->halfedges()) {
-        if (he_face == he) he_found = true;
-        if (he_face == he->mate()) mate_found = true;
-      }
-    }
-    
-    if (!he_found || !mate_found) {
+    if (!isInFace(he) || !isInFace(he->mate())) {
       return false;
     }
     
@@ -1578,6 +1620,117 @@ class EulerOperations {
 
  private:
   std::shared_ptr<MeshL> mesh_;
+
+  // transaction in progress and committed ones (see MeshTransactionL)
+  std::unique_ptr<MeshTransactionL> transaction_;
+  std::vector<std::unique_ptr<MeshTransactionL>> undo_, redo_;
+  uint64_t history_version_ = 0;
+
+  // the history is valid unless the mesh was edited outside of it
+  bool historyValid() const {
+    return (undo_.empty() && redo_.empty()) ||
+           (mesh_->topologyVersion() == history_version_);
+  }
+
+  // save elements in the transaction before they are changed
+  template <class T>
+  void touch(const std::shared_ptr<T>& e) {
+    if (mesh_ && mesh_->editLog() && e) mesh_->editLog()->touch(e);
+  }
+
+  // a face, its halfedges, their vertices and mates
+  static void touchFace(const std::shared_ptr<MeshL>& mesh,
+                        const std::shared_ptr<FaceL>& face) {
+    MeshEditLogL* log = mesh ? mesh->editLog() : nullptr;
+    if (!log || !face) return;
+    log->touch(face);
+    for (auto& he : face->halfedges()) {
+      log->touch(he);
+      if (he->vertex()) log->touch(he->vertex());
+      if (he->mate()) log->touch(he->mate());
+    }
+  }
+
+  // unordered vertex pair of a halfedge
+  struct EdgeKey {
+    const VertexL* a;
+    const VertexL* b;
+    bool operator==(const EdgeKey& k) const { return a == k.a && b == k.b; }
+  };
+  struct EdgeKeyHash {
+    size_t operator()(const EdgeKey& k) const {
+      const size_t h = std::hash<const VertexL*>()(k.a);
+      return h ^ (std::hash<const VertexL*>()(k.b) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+    }
+  };
+  using EdgeMap = std::unordered_map<EdgeKey, std::vector<std::shared_ptr<HalfedgeL>>, EdgeKeyHash>;
+
+  static EdgeKey edgeKey(const std::shared_ptr<HalfedgeL>& he) {
+    const VertexL* v1 = he->vertex().get();
+    const VertexL* v2 = he->next()->vertex().get();
+    if (std::less<const VertexL*>()(v2, v1)) std::swap(v1, v2);
+    return EdgeKey{v1, v2};
+  }
+
+  // he is listed in its face
+  static bool isInFace(const std::shared_ptr<HalfedgeL>& he) {
+    if (!he || !he->face() || !he->vertex()) return false;
+    for (auto& h : he->face()->halfedges())
+      if (h == he) return true;
+    return false;
+  }
+
+  // unmatched halfedges by vertex pair (entries are checked on lookup).
+  // Valid while the mesh is only edited by this object's operations.
+  EdgeMap open_;
+  bool open_valid_ = false;
+  uint64_t open_version_ = 0;
+
+  void rebuildOpenHalfedges() {
+    open_.clear();
+    for (auto& face : mesh_->faces())
+      for (auto& he : face->halfedges())
+        if (!he->mate()) open_[edgeKey(he)].push_back(he);
+    open_valid_ = true;
+  }
+
+  // an unmatched halfedge of another face on he's vertex pair
+  std::shared_ptr<HalfedgeL> findOpenMate(const std::shared_ptr<HalfedgeL>& he) {
+    const EdgeKey key = edgeKey(he);
+    auto it = open_.find(key);
+    if (it == open_.end()) return nullptr;
+    auto& list = it->second;
+    std::shared_ptr<HalfedgeL> found = nullptr;
+    size_t n = 0;
+    for (size_t i = 0; i < list.size(); ++i) {
+      auto& c = list[i];
+      // drop entries that were matched, removed or changed
+      if (c->mate() || !isInFace(c) || !(edgeKey(c) == key)) continue;
+      if (!found && c != he && c->face() != he->face()) {
+        found = c;
+        continue;
+      }
+      list[n++] = c;
+    }
+    list.resize(n);
+    if (list.empty()) open_.erase(it);
+    return found;
+  }
+
+  // brackets an operation: the table of unmatched halfedges stays valid
+  // unless the mesh topology changed since the previous operation
+  class LocalEdit {
+   public:
+    explicit LocalEdit(EulerOperations* eu) : eu_(eu) {
+      if (eu_->mesh_ && eu_->mesh_->topologyVersion() != eu_->open_version_)
+        eu_->open_valid_ = false;
+    }
+    ~LocalEdit() {
+      if (eu_->mesh_) eu_->open_version_ = eu_->mesh_->topologyVersion();
+    }
+   private:
+    EulerOperations* eu_;
+  };
 };
 
 #endif  // _EULEROPERATIONS_HXX
@@ -15,6 +15,7 @@
 
 #include "myEigen.hxx"
 
+#include <iterator>
 #include <list>
 #include <memory>
 //using namespace std;
@@ -67,6 +68,21 @@ public:
     return *(h_iter);
   };
 
+  // raw pointers for read-only traversal (no reference counting; see
+  // VertexLRawCirculator.hxx). Valid while the mesh is not edited.
+  HalfedgeL* nextRaw() const {
+    auto h_iter = std::next(f_iter_);
+    return (h_iter != f_end()) ? h_iter->get() : f_hlist_->front().get();
+  };
+  HalfedgeL* prevRaw() const {
+    return (f_iter_ != f_begin()) ? std::prev(f_iter_)->get() : f_hlist_->back().get();
+  };
+  HalfedgeL* mateRaw() const { return mate_.get(); }
+  VertexL* vertexRaw() const { return vertex_.get(); }
+  FaceL* faceRaw() const { return face_.get(); }
+  NormalL* normalRaw() const { return normal_.get(); }
+  TexcoordL* texcoordRaw() const { return texcoord_.get(); }
+
   // this の前に挿入
   std::list<std::shared_ptr<HalfedgeL> >::iterator binsert( std::shared_ptr<HalfedgeL> new_he ) {
     auto h_iter = f_iter();
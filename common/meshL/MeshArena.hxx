@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////
+//
+// Slab arena for MeshL elements.
+//
+// Elements are created with std::allocate_shared and an ArenaAllocator,
+// so the element and its shared_ptr control block share one fixed-size
+// block taken from a slab.  Slabs grow geometrically and are released
+// when the owning MeshL and every element allocated from the arena are
+// gone (elements that outlive their MeshL keep the arena alive).
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHARENA_HXX
+#define _MESHARENA_HXX 1
+
+#include "envDep.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace meshl_detail {
+
+// pool of fixed-size blocks
+class SlabPool {
+
+ public:
+
+  explicit SlabPool(size_t block_size)
+    : block_size_(roundUp(block_size)), next_slab_blocks_(kMinSlabBlocks),
+      free_(nullptr), cur_(nullptr), end_(nullptr), reserved_(0) {};
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  void* allocate() {
+    if (free_ != nullptr) {
+      FreeNode* p = free_;
+      free_ = p->next;
+      return p;
+    }
+    if (cur_ == end_) addSlab(next_slab_blocks_);
+    void* p = cur_;
+    cur_ += block_size_;
+    return p;
+  };
+
+  void deallocate(void* p) {
+    FreeNode* node = static_cast<FreeNode*>(p);
+    node->next = free_;
+    free_ = node;
+  };
+
+  // make room for n more blocks with (at most) one new slab
+  void reserve(size_t n) {
+    const size_t avail = (size_t)(end_ - cur_) / block_size_;
+    if (n > avail) addSlab(n - avail);
+  };
+
+  size_t blockSize() const { return block_size_; };
+  size_t reservedBytes() const { return reserved_; };
+
+ private:
+
+  struct FreeNode { FreeNode* next; };
+
+  static constexpr size_t kAlign = alignof(std::max_align_t);
+  static constexpr size_t kMinSlabBlocks = 256;
+  static constexpr size_t kMaxSlabBlocks = 1 << 20;
+
+  static size_t roundUp(size_t n) {
+    if (n < sizeof(FreeNode)) n = sizeof(FreeNode);
+    return (n + kAlign - 1) / kAlign * kAlign;
+  };
+
+  void addSlab(size_t n_blocks) {
+    // the rest of the current slab is handed over to the free list
+    while (cur_ != end_) {
+      deallocate(cur_);
+      cur_ += block_size_;
+    }
+    const size_t bytes = n_blocks * block_size_;
+    slabs_.emplace_back(new char[bytes]);
+    cur_ = slabs_.back().get();
+    end_ = cur_ + bytes;
+    reserved_ += bytes;
+    if (next_slab_blocks_ < kMaxSlabBlocks) next_slab_blocks_ *= 2;
+  };
+
+  size_t block_size_;
+  size_t next_slab_blocks_;
+  FreeNode* free_;
+  char* cur_;
+  char* end_;
+  size_t reserved_;
+  std::vector<std::unique_ptr<char[]> > slabs_;
+};
+
+// one SlabPool per block size (i.e. per element type)
+//
+// The arena counts its owners (ArenaRef) and the blocks handed out, and
+// deletes itself when both are gone.  Allocators only hold a raw pointer,
+// which keeps the control blocks of allocate_shared small.
+class MeshArena {
+
+ public:
+
+  static MeshArena* create() { return new MeshArena(); };
+
+  MeshArena(const MeshArena&) = delete;
+  MeshArena& operator=(const MeshArena&) = delete;
+
+  void retain() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++refs_;
+  };
+
+  void release() {
+    bool last;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      last = (--refs_ == 0);
+    }
+    if (last) delete this;
+  };
+
+  // hint: blocks to reserve when the pool has less room than that
+  void* allocate(size_t bytes, size_t align, size_t hint = 0) {
+    if (align > alignof(std::max_align_t)) return ::operator new(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    SlabPool& pool = poolFor(bytes);
+    if (hint) pool.reserve(hint);
+    void* p = pool.allocate();
+    ++refs_;
+    return p;
+  };
+
+  void deallocate(void* p, size_t bytes, size_t align) {
+    if (align > alignof(std::max_align_t)) {
+      ::operator delete(p);
+      return;
+    }
+    bool last;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      poolFor(bytes).deallocate(p);
+      last = (--refs_ == 0);
+    }
+    if (last) delete this;
+  };
+
+  size_t reservedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (auto& p : pools_)
+      if (p) n += p->reservedBytes();
+    return n;
+  };
+
+ private:
+
+  MeshArena() : refs_(0) {};
+  ~MeshArena() {};
+
+  static constexpr size_t kAlign = alignof(std::max_align_t);
+
+  SlabPool& poolFor(size_t bytes) {
+    const size_t c = (bytes + kAlign - 1) / kAlign;
+    if (c >= pools_.size()) pools_.resize(c + 1);
+    if (!pools_[c]) pools_[c].reset(new SlabPool(c * kAlign));
+    return *pools_[c];
+  };
+
+  mutable std::mutex mutex_;
+  size_t refs_;
+  // indexed by size class (bytes / alignof(max_align_t), rounded up)
+  std::vector<std::unique_ptr<SlabPool> > pools_;
+};
+
+// owning handle of a MeshArena (held by MeshL)
+class ArenaRef {
+
+ public:
+
+  ArenaRef() : arena_(nullptr) {};
+  explicit ArenaRef(MeshArena* a) : arena_(a) { if (arena_) arena_->retain(); };
+  ArenaRef(const ArenaRef& r) : arena_(r.arena_) { if (arena_) arena_->retain(); };
+  ArenaRef& operator=(const ArenaRef& r) {
+    if (r.arena_) r.arena_->retain();
+    if (arena_) arena_->release();
+    arena_ = r.arena_;
+    return *this;
+  };
+  ~ArenaRef() { if (arena_) arena_->release(); };
+
+  void reset() { ArenaRef().swap(*this); };
+  void swap(ArenaRef& r) { std::swap(arena_, r.arena_); };
+
+  MeshArena* get() const { return arena_; };
+  MeshArena* operator->() const { return arena_; };
+  explicit operator bool() const { return arena_ != nullptr; };
+
+ private:
+
+  MeshArena* arena_;
+};
+
+// allocator handed to std::allocate_shared
+template <class T>
+class ArenaAllocator {
+
+ public:
+
+  using value_type = T;
+
+  explicit ArenaAllocator(MeshArena* arena, size_t hint = 0)
+    : arena_(arena), hint_(hint) {};
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& a) : arena_(a.arena_), hint_(a.hint_) {};
+
+  T* allocate(size_t n) {
+    if (n != 1) return std::allocator<T>().allocate(n);
+    return static_cast<T*>(arena_->allocate(sizeof(T), alignof(T), hint_));
+  };
+
+  void deallocate(T* p, size_t n) {
+    if (n != 1) {
+      std::allocator<T>().deallocate(p, n);
+      return;
+    }
+    arena_->deallocate(p, sizeof(T), alignof(T));
+  };
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& a) const { return arena_ == a.arena_; };
+  template <class U>
+  bool operator!=(const ArenaAllocator<U>& a) const { return arena_ != a.arena_; };
+
+ private:
+
+  template <class U> friend class ArenaAllocator;
+
+  MeshArena* arena_;
+  size_t hint_;
+};
+
+}  // namespace meshl_detail
+
+#endif // _MESHARENA_HXX
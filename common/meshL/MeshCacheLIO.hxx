@@ -0,0 +1,578 @@
+////////////////////////////////////////////////////////////////////
+//
+// Binary mesh cache (.mlc) for MeshL.
+//
+// Stores positions, optional vertex colors, texcoords, normals, face
+// index arrays, the texcoord / normal of each halfedge, mates and
+// vertex halfedges (when the mesh has connectivity) and boundary
+// loops as flat arrays, so reading needs no text parsing and no
+// createConnectivity().  All sections are 8-byte aligned; the file is
+// mapped with mmap where available and the arrays are read in place.
+//
+//   header   MeshCacheHeader (magic, version, byte order, counts)
+//   double   points[3 nv]
+//   uint8    has_color[nv], double colors[3 nv]        (kColors)
+//   double   texcoords[3 nt], normals[3 nn]
+//   uint32   face_offset[nf + 1], he_vertex[nh]
+//   int32    he_texcoord[nh], he_normal[nh]            (-1: none)
+//   int32    he_mate[nh], v_halfedge[nv]               (kMates)
+//   uint32   bloop_nv[nb], bloop_nh[nb]
+//   int32    bloop_vertex[], uint8 bloop_corner[], int32 bloop_halfedge[]
+//
+// The cache always holds the whole mesh (the save flags of LIO are
+// not used).  Normalized meshes are stored in their original scale as
+// SMFLIO does.
+//
+//   MeshCacheLIO io(mesh);
+//   io.outputToFile("bunny.mlc");
+//   io.inputFromFile("bunny.mlc");
+//   io.inputFromFile("bunny.mlc", compact);   // arrays only, no MeshL
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHCACHELIO_HXX
+#define _MESHCACHELIO_HXX 1
+
+#include "envDep.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "LIO.hxx"
+#include "CompactMesh.hxx"
+#include "ParallelFor.hxx"
+#include "myEigen.hxx"
+
+struct MeshCacheHeader {
+  char magic[8];            // "MESHLC\0\0"
+  uint32_t version;
+  uint32_t byte_order;      // kByteOrder as written
+  uint32_t flags;
+  uint32_t n_vertices;
+  uint32_t n_texcoords;
+  uint32_t n_normals;
+  uint32_t n_faces;
+  uint32_t n_halfedges;
+  uint32_t n_bloops;
+  uint32_t n_bloop_vertices;
+  uint32_t n_bloop_halfedges;
+  uint32_t reserved;
+
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kByteOrder = 0x01020304;
+  enum Flags : uint32_t { kColors = 1, kMates = 2 };
+};
+
+class MeshCacheLIO : public LIO {
+
+ public:
+
+  MeshCacheLIO() : LIO() {};
+  MeshCacheLIO(MeshL& mesh) : LIO(mesh) {};
+  ~MeshCacheLIO() {};
+
+  bool inputFromFile(const char* const filename) {
+    MappedFile file;
+    Sections c;
+    if (!open(filename, file, c)) return false;
+    const MeshCacheHeader& h = c.header;
+    const size_t nv = h.n_vertices, nt = h.n_texcoords, nn = h.n_normals;
+    const size_t nf = h.n_faces, nh = h.n_halfedges, nb = h.n_bloops;
+    const double* points = c.points;
+    const uint8_t* has_color = c.has_color;
+    const double* colors = c.colors;
+    const double* texcoords = c.texcoords;
+    const double* normals = c.normals;
+    const uint32_t* face_offset = c.face_offset;
+    const uint32_t* he_vertex = c.he_vertex;
+    const int32_t* he_texcoord = c.he_texcoord;
+    const int32_t* he_normal = c.he_normal;
+    const int32_t* he_mate = c.he_mate;
+    const int32_t* v_halfedge = c.v_halfedge;
+    const uint32_t* bloop_nv = c.bloop_nv;
+    const uint32_t* bloop_nh = c.bloop_nh;
+    const int32_t* bloop_vertex = c.bloop_vertex;
+    const uint8_t* bloop_corner = c.bloop_corner;
+    const int32_t* bloop_halfedge = c.bloop_halfedge;
+
+    // appended to a non-empty mesh, the stored mates do not cover the
+    // elements already there
+    const bool was_empty = mesh().vertices().empty() && mesh().faces().empty() &&
+                           mesh().halfedges().empty();
+
+    mesh().reserve((int) nv, (int) nf, (int) nh, (int) nt, (int) nn);
+    std::vector<std::shared_ptr<VertexL> > vts(nv);
+    for (size_t i = 0; i < nv; ++i) {
+      Eigen::Vector3d p(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+      vts[i] = mesh().addVertex(p);
+      if (has_color && has_color[i])
+        vts[i]->setColor(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]);
+    }
+    std::vector<std::shared_ptr<TexcoordL> > tcs(nt);
+    for (size_t i = 0; i < nt; ++i) {
+      Eigen::Vector3d p(texcoords[3 * i], texcoords[3 * i + 1], texcoords[3 * i + 2]);
+      tcs[i] = mesh().addTexcoord(p);
+    }
+    std::vector<std::shared_ptr<NormalL> > nms(nn);
+    for (size_t i = 0; i < nn; ++i) {
+      Eigen::Vector3d p(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]);
+      nms[i] = mesh().addNormal(p);
+    }
+
+    std::vector<std::shared_ptr<HalfedgeL> > hes(nh);
+    std::vector<FaceL*> faces(nf);
+    for (size_t f = 0; f < nf; ++f) {
+      std::shared_ptr<FaceL> fc = mesh().addFace();
+      for (uint32_t i = face_offset[f]; i < face_offset[f + 1]; ++i) {
+        hes[i] = mesh().addHalfedge(fc, vts[he_vertex[i]],
+                                    (he_normal[i] >= 0) ? nms[he_normal[i]] : nullptr,
+                                    (he_texcoord[i] >= 0) ? tcs[he_texcoord[i]] : nullptr);
+      }
+      faces[f] = fc.get();
+    }
+    par_util::parallelFor(0, faces.size(), [&](size_t i) {
+      if (faces[i]->size() >= 3) faces[i]->calcNormal();
+    });
+
+    if (he_mate) {
+      for (size_t i = 0; i < nh; ++i)
+        if (he_mate[i] >= 0) hes[i]->setMate(hes[he_mate[i]]);
+      for (size_t i = 0; i < nv; ++i)
+        if (v_halfedge[i] >= 0) vts[i]->setHalfedge(hes[v_halfedge[i]]);
+      if (was_empty) mesh().setConnectivity(true);
+    }
+
+    size_t iv = 0, ih = 0;
+    for (size_t b = 0; b < nb; ++b) {
+      std::shared_ptr<BLoopL> bl = mesh().addBLoop();
+      for (uint32_t i = 0; i < bloop_nv[b]; ++i, ++iv) {
+        bl->addVertex(vts[bloop_vertex[iv]]);
+        bl->addIsCorner(bloop_corner[iv] != 0);
+      }
+      for (uint32_t i = 0; i < bloop_nh[b]; ++i, ++ih) bl->addHalfedge(hes[bloop_halfedge[ih]]);
+    }
+
+    mesh().printInfo();
+
+    return true;
+  };
+
+  //
+  // arrays only, without MeshL elements (boundary loops are skipped):
+  // costs little more than copying the mapped sections
+  //
+  bool inputFromFile(const char* const filename, CompactMesh& cm) {
+    MappedFile file;
+    Sections c;
+    if (!open(filename, file, c)) return false;
+    const MeshCacheHeader& h = c.header;
+    const size_t nv = h.n_vertices, nh = h.n_halfedges, nf = h.n_faces;
+    cm.clear();
+    cm.points_.resize(nv);
+    for (size_t i = 0; i < nv; ++i)
+      cm.points_[i] = Eigen::Vector3d(c.points[3 * i], c.points[3 * i + 1], c.points[3 * i + 2]);
+    if (c.has_color) {
+      cm.colors_.resize(nv);
+      for (size_t i = 0; i < nv; ++i)
+        cm.colors_[i] = Eigen::Vector3d(c.colors[3 * i], c.colors[3 * i + 1], c.colors[3 * i + 2]);
+    }
+    cm.texcoords_.resize(h.n_texcoords);
+    for (size_t i = 0; i < cm.texcoords_.size(); ++i)
+      cm.texcoords_[i] = Eigen::Vector3d(c.texcoords[3 * i], c.texcoords[3 * i + 1], c.texcoords[3 * i + 2]);
+    cm.normals_.resize(h.n_normals);
+    for (size_t i = 0; i < cm.normals_.size(); ++i)
+      cm.normals_[i] = Eigen::Vector3d(c.normals[3 * i], c.normals[3 * i + 1], c.normals[3 * i + 2]);
+
+    cm.he_vertex_.assign(c.he_vertex, c.he_vertex + nh);
+    bool any_t = false, any_n = false;
+    for (size_t i = 0; i < nh; ++i) {
+      any_t = any_t || (c.he_texcoord[i] >= 0);
+      any_n = any_n || (c.he_normal[i] >= 0);
+    }
+    if (any_t) cm.he_texcoord_.assign(c.he_texcoord, c.he_texcoord + nh);
+    if (any_n) cm.he_normal_.assign(c.he_normal, c.he_normal + nh);
+    cm.n_faces_ = (CompactMesh::Index) nf;
+    cm.is_triangle_ = true;
+    for (size_t f = 0; f < nf; ++f)
+      if (c.face_offset[f] != 3 * f) cm.is_triangle_ = false;
+    if (c.face_offset[nf] != 3 * nf) cm.is_triangle_ = false;
+    if (!cm.is_triangle_) {
+      cm.f_offset_.assign(c.face_offset, c.face_offset + nf + 1);
+      cm.he_face_.resize(nh);
+      for (size_t f = 0; f < nf; ++f)
+        for (uint32_t i = c.face_offset[f]; i < c.face_offset[f + 1]; ++i) cm.he_face_[i] = (CompactMesh::Index) f;
+    }
+    if (c.he_mate) {
+      cm.he_mate_.assign(c.he_mate, c.he_mate + nh);
+      cm.v_halfedge_.assign(c.v_halfedge, c.v_halfedge + nv);
+      cm.is_mates_ = true;
+    } else {
+      cm.he_mate_.assign(nh, CompactMesh::kInvalid);
+      cm.v_halfedge_.assign(nv, CompactMesh::kInvalid);
+    }
+    return true;
+  };
+
+  bool outputToFile(const char* const filename) {
+    mesh().printInfo();
+
+    MeshCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kMagic, 8);
+    h.version = MeshCacheHeader::kVersion;
+    h.byte_order = MeshCacheHeader::kByteOrder;
+
+    // elements -> positions in their lists
+    std::unordered_map<const VertexL*, int32_t> vmap;
+    std::unordered_map<const TexcoordL*, int32_t> tmap;
+    std::unordered_map<const NormalL*, int32_t> nmap;
+    std::unordered_map<const HalfedgeL*, int32_t> hmap;
+    vmap.reserve(mesh().vertices_size());
+
+    std::vector<double> points, colors;
+    std::vector<uint8_t> has_color;
+    points.reserve(3 * mesh().vertices_size());
+    for (auto& vt : mesh().vertices()) {
+      vmap[vt.get()] = (int32_t) vmap.size();
+      Eigen::Vector3d p = vt->point();
+      if (mesh().isNormalized()) p = p * mesh().maxLength() + mesh().center();
+      points.insert(points.end(), {p.x(), p.y(), p.z()});
+      has_color.push_back(vt->hasColor() ? 1 : 0);
+      if (vt->hasColor()) h.flags |= MeshCacheHeader::kColors;
+    }
+    if (h.flags & MeshCacheHeader::kColors) {
+      colors.assign(3 * has_color.size(), 0.0);
+      size_t i = 0;
+      for (auto& vt : mesh().vertices()) {
+        if (vt->hasColor()) {
+          const Eigen::Vector3d& c = vt->color();
+          colors[3 * i] = c.x(); colors[3 * i + 1] = c.y(); colors[3 * i + 2] = c.z();
+        }
+        ++i;
+      }
+    }
+    std::vector<double> texcoords, normals;
+    for (auto& tc : mesh().texcoords()) {
+      tmap[tc.get()] = (int32_t) tmap.size();
+      texcoords.insert(texcoords.end(), {tc->point().x(), tc->point().y(), tc->point().z()});
+    }
+    for (auto& nm : mesh().normals()) {
+      nmap[nm.get()] = (int32_t) nmap.size();
+      normals.insert(normals.end(), {nm->point().x(), nm->point().y(), nm->point().z()});
+    }
+
+    std::vector<uint32_t> face_offset(1, 0), he_vertex;
+    std::vector<int32_t> he_texcoord, he_normal;
+    std::vector<const HalfedgeL*> hes;
+    for (auto& fc : mesh().faces()) {
+      for (auto& he : fc->halfedges()) {
+        hmap[he.get()] = (int32_t) hes.size();
+        hes.push_back(he.get());
+        he_vertex.push_back((uint32_t) find(vmap, he->vertex().get()));
+        he_texcoord.push_back(find(tmap, he->texcoord().get()));
+        he_normal.push_back(find(nmap, he->normal().get()));
+      }
+      face_offset.push_back((uint32_t) hes.size());
+    }
+    for (uint32_t v : he_vertex)
+      if ((int32_t) v < 0) {
+        std::cerr << "Halfedge vertex not in the mesh" << std::endl;
+        return false;
+      }
+
+    std::vector<int32_t> he_mate, v_halfedge;
+    if (mesh().isConnectivity()) {
+      h.flags |= MeshCacheHeader::kMates;
+      he_mate.resize(hes.size());
+      for (size_t i = 0; i < hes.size(); ++i) he_mate[i] = find(hmap, hes[i]->mate().get());
+      for (auto& vt : mesh().vertices()) v_halfedge.push_back(find(hmap, vt->halfedge().get()));
+    }
+
+    std::vector<uint32_t> bloop_nv, bloop_nh;
+    std::vector<int32_t> bloop_vertex, bloop_halfedge;
+    std::vector<uint8_t> bloop_corner;
+    for (auto& bl : mesh().bloops()) {
+      const uint32_t n = (uint32_t) bl->vertices().size();
+      for (uint32_t i = 0; i < n; ++i) {
+        bloop_vertex.push_back(find(vmap, bl->vertex(i).get()));
+        bloop_corner.push_back(bl->isCorner(i) ? 1 : 0);
+      }
+      uint32_t m = 0;
+      for (auto& he : bl->halfedges()) {
+        const int32_t i = find(hmap, he.get());
+        if (i < 0) continue;
+        bloop_halfedge.push_back(i);
+        ++m;
+      }
+      bloop_nv.push_back(n);
+      bloop_nh.push_back(m);
+    }
+
+    h.n_vertices = (uint32_t) has_color.size();
+    h.n_texcoords = (uint32_t) tmap.size();
+    h.n_normals = (uint32_t) nmap.size();
+    h.n_faces = (uint32_t) face_offset.size() - 1;
+    h.n_halfedges = (uint32_t) hes.size();
+    h.n_bloops = (uint32_t) bloop_nv.size();
+    h.n_bloop_vertices = (uint32_t) bloop_vertex.size();
+    h.n_bloop_halfedges = (uint32_t) bloop_halfedge.size();
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == nullptr) return false;
+    Writer out(fp);
+    out.write(&h, 1);
+    out.write(points);
+    if (h.flags & MeshCacheHeader::kColors) {
+      out.write(has_color);
+      out.write(colors);
+    }
+    out.write(texcoords);
+    out.write(normals);
+    out.write(face_offset);
+    out.write(he_vertex);
+    out.write(he_texcoord);
+    out.write(he_normal);
+    if (h.flags & MeshCacheHeader::kMates) {
+      out.write(he_mate);
+      out.write(v_halfedge);
+    }
+    out.write(bloop_nv);
+    out.write(bloop_nh);
+    out.write(bloop_vertex);
+    out.write(bloop_corner);
+    out.write(bloop_halfedge);
+    const bool ok = out.ok();
+    fclose(fp);
+    return ok;
+  };
+
+ private:
+
+  static constexpr char kMagic[8] = {'M', 'E', 'S', 'H', 'L', 'C', 0, 0};
+
+  // sections of a mapped file
+  struct Sections {
+    MeshCacheHeader header;
+    const double* points = nullptr;
+    const uint8_t* has_color = nullptr;
+    const double* colors = nullptr;
+    const double* texcoords = nullptr;
+    const double* normals = nullptr;
+    const uint32_t* face_offset = nullptr;
+    const uint32_t* he_vertex = nullptr;
+    const int32_t* he_texcoord = nullptr;
+    const int32_t* he_normal = nullptr;
+    const int32_t* he_mate = nullptr;
+    const int32_t* v_halfedge = nullptr;
+    const uint32_t* bloop_nv = nullptr;
+    const uint32_t* bloop_nh = nullptr;
+    const int32_t* bloop_vertex = nullptr;
+    const uint8_t* bloop_corner = nullptr;
+    const int32_t* bloop_halfedge = nullptr;
+  };
+
+  class MappedFile;
+
+  bool open(const char* const filename, MappedFile& file, Sections& c) {
+    if (!file.open(filename)) {
+      std::cerr << "Cannot open " << filename << std::endl;
+      return false;
+    }
+    Reader in(file.data(), file.size());
+    MeshCacheHeader& h = c.header;
+    if (!in.read(&h, 1) || memcmp(h.magic, kMagic, 8) ||
+        (h.version != MeshCacheHeader::kVersion) ||
+        (h.byte_order != MeshCacheHeader::kByteOrder)) {
+      std::cerr << "Not a mesh cache (or other version / byte order): " << filename << std::endl;
+      return false;
+    }
+    const size_t nv = h.n_vertices, nt = h.n_texcoords, nn = h.n_normals;
+    const size_t nf = h.n_faces, nh = h.n_halfedges, nb = h.n_bloops;
+    c.points = in.array<double>(3 * nv);
+    if (h.flags & MeshCacheHeader::kColors) {
+      c.has_color = in.array<uint8_t>(nv);
+      c.colors = in.array<double>(3 * nv);
+    }
+    c.texcoords = in.array<double>(3 * nt);
+    c.normals = in.array<double>(3 * nn);
+    c.face_offset = in.array<uint32_t>(nf + 1);
+    c.he_vertex = in.array<uint32_t>(nh);
+    c.he_texcoord = in.array<int32_t>(nh);
+    c.he_normal = in.array<int32_t>(nh);
+    if (h.flags & MeshCacheHeader::kMates) {
+      c.he_mate = in.array<int32_t>(nh);
+      c.v_halfedge = in.array<int32_t>(nv);
+    }
+    c.bloop_nv = in.array<uint32_t>(nb);
+    c.bloop_nh = in.array<uint32_t>(nb);
+    c.bloop_vertex = in.array<int32_t>(h.n_bloop_vertices);
+    c.bloop_corner = in.array<uint8_t>(h.n_bloop_vertices);
+    c.bloop_halfedge = in.array<int32_t>(h.n_bloop_halfedges);
+    if (!in.ok() || !validate(h, c.face_offset, c.he_vertex, c.he_texcoord, c.he_normal,
+                              c.he_mate, c.v_halfedge, c.bloop_nv, c.bloop_nh,
+                              c.bloop_vertex, c.bloop_halfedge)) {
+      std::cerr << "Broken mesh cache: " << filename << std::endl;
+      return false;
+    }
+    return true;
+  };
+
+  template <class T>
+  static int32_t find(const std::unordered_map<const T*, int32_t>& m, const T* e) {
+    if (e == nullptr) return -1;
+    auto it = m.find(e);
+    return (it == m.end()) ? -1 : it->second;
+  };
+
+  // indices in range (a corrupt file must not crash the reader)
+  static bool validate(const MeshCacheHeader& h, const uint32_t* face_offset,
+                       const uint32_t* he_vertex, const int32_t* he_texcoord,
+                       const int32_t* he_normal, const int32_t* he_mate,
+                       const int32_t* v_halfedge, const uint32_t* bloop_nv,
+                       const uint32_t* bloop_nh, const int32_t* bloop_vertex,
+                       const int32_t* bloop_halfedge) {
+    if ((face_offset[0] != 0) || (face_offset[h.n_faces] != h.n_halfedges)) return false;
+    for (uint32_t f = 0; f < h.n_faces; ++f)
+      if (face_offset[f + 1] < face_offset[f]) return false;
+    auto in = [](int64_t i, uint32_t n, bool none) {
+      return (none && (i == -1)) || ((i >= 0) && (i < (int64_t) n));
+    };
+    for (uint32_t i = 0; i < h.n_halfedges; ++i) {
+      if (!in(he_vertex[i], h.n_vertices, false) || !in(he_texcoord[i], h.n_texcoords, true) ||
+          !in(he_normal[i], h.n_normals, true))
+        return false;
+      if (he_mate && !in(he_mate[i], h.n_halfedges, true)) return false;
+    }
+    if (v_halfedge)
+      for (uint32_t i = 0; i < h.n_vertices; ++i)
+        if (!in(v_halfedge[i], h.n_halfedges, true)) return false;
+    uint64_t sv = 0, sh = 0;
+    for (uint32_t b = 0; b < h.n_bloops; ++b) {
+      sv += bloop_nv[b];
+      sh += bloop_nh[b];
+    }
+    if ((sv != h.n_bloop_vertices) || (sh != h.n_bloop_halfedges)) return false;
+    for (uint32_t i = 0; i < h.n_bloop_vertices; ++i)
+      if (!in(bloop_vertex[i], h.n_vertices, false)) return false;
+    for (uint32_t i = 0; i < h.n_bloop_halfedges; ++i)
+      if (!in(bloop_halfedge[i], h.n_halfedges, false)) return false;
+    return true;
+  };
+
+  static size_t padded(size_t n) { return (n + 7) & ~(size_t) 7; };
+
+  // sequential, 8-byte aligned sections of a mapped file
+  class Reader {
+   public:
+    Reader(const char* data, size_t size) : data_(data), size_(size) {};
+    template <class T>
+    bool read(T* v, size_t n) {
+      const T* p = array<T>(n);
+      if (p && n) memcpy(v, p, n * sizeof(T));
+      return ok_;
+    };
+    template <class T>
+    const T* array(size_t n) {
+      const size_t bytes = n * sizeof(T);
+      if (!ok_ || (pos_ + bytes > size_)) {
+        ok_ = false;
+        return nullptr;
+      }
+      const T* p = reinterpret_cast<const T*>(data_ + pos_);
+      pos_ += padded(bytes);
+      return p;
+    };
+    bool ok() const { return ok_; };
+   private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+  };
+
+  class Writer {
+   public:
+    Writer(FILE* fp) : fp_(fp) {};
+    template <class T>
+    void write(const T* v, size_t n) {
+      const size_t bytes = n * sizeof(T);
+      if (bytes && (fwrite(v, 1, bytes, fp_) != bytes)) ok_ = false;
+      static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+      const size_t pad = padded(bytes) - bytes;
+      if (pad && (fwrite(zero, 1, pad, fp_) != pad)) ok_ = false;
+    };
+    template <class T>
+    void write(const std::vector<T>& v) { write(v.data(), v.size()); };
+    bool ok() const { return ok_; };
+   private:
+    FILE* fp_;
+    bool ok_ = true;
+  };
+
+  // read-only mapping (whole file read where mmap is not available)
+  class MappedFile {
+   public:
+    ~MappedFile() { close(); };
+    bool open(const char* const filename) {
+#if !defined(_WIN32)
+      const int fd = ::open(filename, O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+        void* p = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+          map_ = p;
+          size_ = (size_t) st.st_size;
+        }
+      }
+      ::close(fd);
+      if (map_) return true;
+#endif
+      FILE* fp = fopen(filename, "rb");
+      if (fp == nullptr) return false;
+      char tmp[1 << 16];
+      size_t m;
+      while ((m = fread(tmp, 1, sizeof(tmp), fp)) > 0) buf_.append(tmp, m);
+      fclose(fp);
+      // sections are read in place: keep them 8-byte aligned
+      aligned_.resize((buf_.size() + 7) / 8);
+      if (!buf_.empty()) memcpy(aligned_.data(), buf_.data(), buf_.size());
+      size_ = buf_.size();
+      buf_.clear();
+      return true;
+    };
+    const char* data() const {
+      return map_ ? (const char*) map_ : (const char*) aligned_.data();
+    };
+    size_t size() const { return size_; };
+   private:
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::string buf_;
+    std::vector<uint64_t> aligned_;
+    void close() {
+#if !defined(_WIN32)
+      if (map_) munmap(map_, size_);
+#endif
+      map_ = nullptr;
+    };
+  };
+};
+
+#endif // _MESHCACHELIO_HXX
@@ -0,0 +1,489 @@
+////////////////////////////////////////////////////////////////////
+//
+// Quadric error metric (QEM) edge-collapse decimation of a MeshL.
+//
+// The mesh is copied into index arrays (polygons are split into
+// fans).  Each vertex carries the quadric of its face planes (plus
+// planes perpendicular to boundary edges); edge collapses are taken
+// from a priority queue ordered by quadric error.  The queue is lazy:
+// entries carry the versions of both vertices and are skipped when
+// either changed, and new entries are pushed for the edges around the
+// kept vertex.  A collapse is rejected when it breaks the link
+// condition (the two vertices must share exactly the opposite vertices
+// of the edge, as EulerOperations::canKillEdgeVertex requires a
+// manifold one-ring), joins two boundaries through the interior, or
+// flips a face.  Boundary and UV-seam vertices can be locked.
+//
+// decimate() stops at a face count or an error bound and may be called
+// again with a smaller target, so decimateLOD() builds a chain of
+// levels in a single run.
+//
+//   MeshDecimatorL dec(mesh);
+//   dec.setLockBoundary(true);
+//   auto lods = dec.decimateLOD({50000, 20000, 5000});
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHDECIMATORL_HXX
+#define _MESHDECIMATORL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "myEigen.hxx"
+
+#include "MeshL.hxx"
+#include "CompactMesh.hxx"
+
+class MeshDecimatorL {
+
+ public:
+
+  MeshDecimatorL(std::shared_ptr<MeshL> mesh) { load(*mesh); };
+
+  // boundary / UV-seam vertices are never removed nor moved
+  void setLockBoundary(bool f) { lock_boundary_ = f; is_queue_ = false; };
+  void setLockSeams(bool f) { lock_seams_ = f; is_queue_ = false; };
+  // weight of the planes perpendicular to boundary edges
+  void setBoundaryWeight(double w) { boundary_weight_ = w; is_queue_ = false; };
+  void setVerbose(bool f) { verbose_ = f; };
+
+  int numFaces() const { return n_faces_; };
+  int numVertices() const { return n_vertices_; };
+  // largest quadric error (squared distance) of a collapse so far
+  double error() const { return error_; };
+
+  //
+  // collapses edges until target_faces remain or the next collapse
+  // would exceed max_error.  Returns the number of faces.
+  //
+  int decimate(int target_faces,
+               double max_error = std::numeric_limits<double>::infinity()) {
+    if (!is_queue_) initQueue();
+    int n_collapses = 0;
+    while ((n_faces_ > target_faces) && !queue_.empty()) {
+      Collapse c = queue_.top();
+      if (c.cost > max_error) break;
+      queue_.pop();
+      if (removed_[c.keep] || removed_[c.remove] ||
+          (c.keep_stamp != stamp_[c.keep]) || (c.remove_stamp != stamp_[c.remove]))
+        continue;
+      if (!canCollapse(c.keep, c.remove, c.point)) continue;
+      collapse(c.keep, c.remove, c.point);
+      error_ = std::max(error_, c.cost);
+      ++n_collapses;
+    }
+    if (verbose_) {
+      std::cout << "decimate: " << n_collapses << " collapses, faces " << n_faces_
+                << " error " << error_ << std::endl;
+    }
+    return n_faces_;
+  };
+
+  //
+  // one mesh per target face count (largest first)
+  //
+  std::vector<std::shared_ptr<MeshL> > decimateLOD(
+      std::vector<int> targets,
+      double max_error = std::numeric_limits<double>::infinity()) {
+    std::sort(targets.begin(), targets.end(), std::greater<int>());
+    std::vector<std::shared_ptr<MeshL> > lods;
+    for (int t : targets) {
+      decimate(t, max_error);
+      auto mesh = std::make_shared<MeshL>();
+      toMeshL(*mesh);
+      lods.push_back(mesh);
+    }
+    return lods;
+  };
+
+  //
+  // current result (mesh is cleared; mates are created)
+  //
+  void toCompactMesh(CompactMesh& cm) const {
+    cm.clear();
+    std::vector<int> vmap(points_.size(), -1);
+    for (size_t v = 0; v < points_.size(); ++v)
+      if (!removed_[v] && !vfaces_[v].empty()) vmap[v] = cm.addVertex(points_[v]);
+    std::vector<int> tmap(texcoords_.size(), -1);
+    for (size_t f = 0; f < tris_.size(); ++f) {
+      if (!alive_[f]) continue;
+      CompactMesh::Index vids[3], tids[3];
+      for (int i = 0; i < 3; ++i) {
+        vids[i] = vmap[tris_[f][i]];
+        tids[i] = CompactMesh::kInvalid;
+        if (!ttex_.empty() && (ttex_[f][i] >= 0)) {
+          int& t = tmap[ttex_[f][i]];
+          if (t < 0) t = cm.addTexcoord(texcoords_[ttex_[f][i]]);
+          tids[i] = t;
+        }
+      }
+      cm.addFace(vids, 3, ttex_.empty() ? nullptr : tids);
+    }
+    cm.buildMates();
+  };
+
+  void toMeshL(MeshL& mesh) const {
+    CompactMesh cm;
+    toCompactMesh(cm);
+    cm.toMeshL(mesh);
+  };
+
+ private:
+
+  // symmetric 4x4 matrix of a quadric, upper triangle
+  struct Quadric {
+    double a[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    // plane n.x + d = 0, weight w
+    void addPlane(const Eigen::Vector3d& n, double d, double w) {
+      a[0] += w * n.x() * n.x(); a[1] += w * n.x() * n.y(); a[2] += w * n.x() * n.z();
+      a[3] += w * n.x() * d;     a[4] += w * n.y() * n.y(); a[5] += w * n.y() * n.z();
+      a[6] += w * n.y() * d;     a[7] += w * n.z() * n.z(); a[8] += w * n.z() * d;
+      a[9] += w * d * d;
+    };
+    Quadric& operator+=(const Quadric& q) {
+      for (int i = 0; i < 10; ++i) a[i] += q.a[i];
+      return *this;
+    };
+    double eval(const Eigen::Vector3d& p) const {
+      const double x = p.x(), y = p.y(), z = p.z();
+      return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x +
+             a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y +
+             a[7] * z * z + 2 * a[8] * z + a[9];
+    };
+    // minimizer; false if the 3x3 part is (nearly) singular
+    bool optimum(Eigen::Vector3d& p) const {
+      Eigen::Matrix3d A;
+      A << a[0], a[1], a[2], a[1], a[4], a[5], a[2], a[5], a[7];
+      const double det = A.determinant();
+      const double scale = A.cwiseAbs().maxCoeff();
+      if (std::fabs(det) <= 1.0e-12 * scale * scale * scale) return false;
+      p = A.inverse() * Eigen::Vector3d(-a[3], -a[6], -a[8]);
+      return true;
+    };
+  };
+
+  struct Collapse {
+    double cost;
+    int keep, remove;
+    uint32_t keep_stamp, remove_stamp;
+    Eigen::Vector3d point;
+    bool operator<(const Collapse& c) const { return cost > c.cost; };  // min-heap
+  };
+
+  // mesh
+  std::vector<Eigen::Vector3d> points_;
+  std::vector<Eigen::Vector3d> texcoords_;
+  std::vector<std::array<int, 3> > tris_;
+  std::vector<std::array<int, 3> > ttex_;  // empty without texcoords
+  std::vector<char> alive_;
+  std::vector<std::vector<int> > vfaces_;  // incident faces (dead ones pruned lazily)
+  std::vector<int> boundary_edges_;        // 3 * face + corner
+  int n_faces_ = 0;
+  int n_vertices_ = 0;
+
+  // per vertex
+  std::vector<Quadric> quadrics_;
+  std::vector<uint32_t> stamp_;
+  std::vector<char> removed_;
+  std::vector<char> boundary_;
+  std::vector<char> seam_;
+
+  std::priority_queue<Collapse> queue_;
+  bool is_queue_ = false;
+  double error_ = 0.0;
+
+  bool lock_boundary_ = false;
+  bool lock_seams_ = false;
+  double boundary_weight_ = 100.0;
+  bool verbose_ = false;
+
+  // neighbor marks
+  std::vector<uint32_t> mark_;
+  uint32_t mark_id_ = 0;
+
+  void load(MeshL& mesh) {
+    std::unordered_map<const VertexL*, int> vmap;
+    vmap.reserve(mesh.vertices_size());
+    for (auto& vt : mesh.vertices()) {
+      vmap[vt.get()] = (int) points_.size();
+      points_.push_back(vt->point());
+    }
+    std::unordered_map<const TexcoordL*, int> tmap;
+    for (auto& tc : mesh.texcoords()) {
+      tmap[tc.get()] = (int) texcoords_.size();
+      texcoords_.push_back(tc->point());
+    }
+    std::vector<int> vids, tids;
+    size_t n_skipped = 0;
+    for (auto& fc : mesh.faces()) {
+      vids.clear(); tids.clear();
+      bool valid = true;
+      for (auto& he : fc->halfedges()) {
+        auto iv = vmap.find(he->vertexRaw());
+        if (iv == vmap.end()) {
+          valid = false;
+          break;
+        }
+        vids.push_back(iv->second);
+        int t = -1;
+        if (he->texcoord()) {
+          auto it = tmap.find(he->texcoord().get());
+          if (it != tmap.end()) t = it->second;
+        }
+        tids.push_back(t);
+      }
+      if (!valid) {
+        ++n_skipped;
+        continue;
+      }
+      for (size_t i = 1; i + 1 < vids.size(); ++i) {
+        tris_.push_back({vids[0], vids[i], vids[i + 1]});
+        ttex_.push_back({tids[0], tids[i], tids[i + 1]});
+      }
+    }
+    if (n_skipped)
+      std::cerr << "Halfedge vertex not in the mesh: " << n_skipped << " faces skipped" << std::endl;
+    if (texcoords_.empty()) ttex_.clear();
+
+    const int nv = (int) points_.size();
+    const int nf = (int) tris_.size();
+    alive_.assign(nf, 1);
+    vfaces_.assign(nv, std::vector<int>());
+    for (int f = 0; f < nf; ++f)
+      for (int v : tris_[f]) vfaces_[v].push_back(f);
+    n_faces_ = nf;
+    n_vertices_ = 0;
+    for (int v = 0; v < nv; ++v)
+      if (!vfaces_[v].empty()) ++n_vertices_;
+    stamp_.assign(nv, 0);
+    removed_.assign(nv, 0);
+    mark_.assign(nv, 0);
+
+    // boundary: edges of a single face
+    boundary_.assign(nv, 0);
+    std::vector<std::pair<uint64_t, int> > keys;
+    keys.reserve(3 * nf);
+    for (int f = 0; f < nf; ++f)
+      for (int i = 0; i < 3; ++i)
+        keys.push_back(std::make_pair(CompactMesh::edgeKey(tris_[f][i], tris_[f][(i + 1) % 3]), 3 * f + i));
+    std::sort(keys.begin(), keys.end());
+    boundary_edges_.clear();
+    for (size_t i = 0; i < keys.size();) {
+      size_t j = i + 1;
+      while ((j < keys.size()) && (keys[j].first == keys[i].first)) ++j;
+      if (j - i == 1) {
+        const int f = keys[i].second / 3, k = keys[i].second % 3;
+        boundary_edges_.push_back(keys[i].second);
+        boundary_[tris_[f][k]] = 1;
+        boundary_[tris_[f][(k + 1) % 3]] = 1;
+      }
+      i = j;
+    }
+
+    // seam: corners of a vertex with different texcoords
+    seam_.assign(nv, 0);
+    if (!ttex_.empty()) {
+      std::vector<int> first(nv, -2);
+      for (int f = 0; f < nf; ++f)
+        for (int i = 0; i < 3; ++i) {
+          int& t = first[tris_[f][i]];
+          if (t == -2) t = ttex_[f][i];
+          else if (t != ttex_[f][i]) seam_[tris_[f][i]] = 1;
+        }
+    }
+  };
+
+  bool isLocked(int v) const {
+    return (lock_boundary_ && boundary_[v]) || (lock_seams_ && seam_[v]);
+  };
+
+  Eigen::Vector3d faceNormal(int f) const {
+    const auto& t = tris_[f];
+    return (points_[t[1]] - points_[t[0]]).cross(points_[t[2]] - points_[t[0]]);
+  };
+
+  void initQueue() {
+    const int nv = (int) points_.size();
+    quadrics_.assign(nv, Quadric());
+    for (int f = 0; f < (int) tris_.size(); ++f) {
+      if (!alive_[f]) continue;
+      Eigen::Vector3d n = faceNormal(f);
+      const double area2 = n.norm();
+      if (area2 <= 0.0) continue;
+      n /= area2;
+      const double d = -n.dot(points_[tris_[f][0]]);
+      // area weighted
+      for (int v : tris_[f]) quadrics_[v].addPlane(n, d, 0.5 * area2);
+    }
+    for (int e : boundary_edges_) {
+      const int f = e / 3, k = e % 3;
+      if (!alive_[f]) continue;
+      const int a = tris_[f][k], b = tris_[f][(k + 1) % 3];
+      const Eigen::Vector3d dir = points_[b] - points_[a];
+      Eigen::Vector3d n = dir.cross(faceNormal(f));
+      if (n.norm() <= 0.0) continue;
+      n.normalize();
+      const double d = -n.dot(points_[a]);
+      const double w = boundary_weight_ * dir.squaredNorm();
+      quadrics_[a].addPlane(n, d, w);
+      quadrics_[b].addPlane(n, d, w);
+    }
+
+    queue_ = std::priority_queue<Collapse>();
+    for (int f = 0; f < (int) tris_.size(); ++f) {
+      if (!alive_[f]) continue;
+      for (int i = 0; i < 3; ++i) {
+        const int a = tris_[f][i], b = tris_[f][(i + 1) % 3];
+        // each interior edge once (from the smaller vertex); boundary edges too
+        if ((a < b) || boundary_[a] || boundary_[b]) pushEdge(a, b);
+      }
+    }
+    is_queue_ = true;
+  };
+
+  void pushEdge(int a, int b) {
+    const bool la = isLocked(a), lb = isLocked(b);
+    if (la && lb) return;
+    Quadric q = quadrics_[a];
+    q += quadrics_[b];
+    Collapse c;
+    if (la || lb) {
+      c.keep = la ? a : b;
+      c.remove = la ? b : a;
+      c.point = points_[c.keep];
+    } else {
+      c.keep = a;
+      c.remove = b;
+      if (!q.optimum(c.point)) {
+        const Eigen::Vector3d mid = 0.5 * (points_[a] + points_[b]);
+        c.point = mid;
+        double best = q.eval(mid);
+        for (const Eigen::Vector3d& p : {points_[a], points_[b]}) {
+          const double e = q.eval(p);
+          if (e < best) { best = e; c.point = p; }
+        }
+      }
+    }
+    c.cost = std::max(0.0, q.eval(c.point));
+    c.keep_stamp = stamp_[c.keep];
+    c.remove_stamp = stamp_[c.remove];
+    queue_.push(c);
+  };
+
+  void pruneFaces(int v) {
+    auto& fs = vfaces_[v];
+    fs.erase(std::remove_if(fs.begin(), fs.end(), [&](int f) { return !alive_[f]; }), fs.end());
+  };
+
+  static bool hasVertex(const std::array<int, 3>& t, int v) {
+    return (t[0] == v) || (t[1] == v) || (t[2] == v);
+  };
+
+  bool canCollapse(int keep, int remove, const Eigen::Vector3d& p) {
+    pruneFaces(keep);
+    pruneFaces(remove);
+
+    // link condition: common neighbors == opposite vertices of the edge
+    mark_id_ += 2;
+    const uint32_t m0 = mark_id_ - 1, m1 = mark_id_;
+    int n_keep = 0;
+    for (int f : vfaces_[keep])
+      for (int w : tris_[f])
+        if ((w != keep) && (mark_[w] != m0)) { mark_[w] = m0; ++n_keep; }
+    int n_remove = 0, n_common = 0, n_edge_faces = 0;
+    for (int f : vfaces_[remove]) {
+      if (hasVertex(tris_[f], keep)) ++n_edge_faces;
+      for (int w : tris_[f]) {
+        if ((w == remove) || (w == keep) || (mark_[w] == m1)) continue;
+        if (mark_[w] == m0) ++n_common;
+        mark_[w] = m1;
+        ++n_remove;
+      }
+    }
+    if ((n_edge_faces == 0) || (n_edge_faces > 2)) return false;
+    if (n_common != n_edge_faces) return false;
+    const bool is_boundary_edge = (n_edge_faces == 1);
+    if (!is_boundary_edge && boundary_[keep] && boundary_[remove]) return false;
+    // remaining one-ring of keep (keep's count includes remove)
+    const int n_ring = (n_keep - 1) + n_remove - n_common;
+    if (n_ring < (is_boundary_edge ? 2 : 3)) return false;
+
+    // no face flips or degenerates
+    for (int v : {keep, remove}) {
+      for (int f : vfaces_[v]) {
+        const auto& t = tris_[f];
+        if (hasVertex(t, keep) && hasVertex(t, remove)) continue;
+        const Eigen::Vector3d n0 = faceNormal(f);
+        Eigen::Vector3d q[3];
+        for (int i = 0; i < 3; ++i) q[i] = ((t[i] == keep) || (t[i] == remove)) ? p : points_[t[i]];
+        const Eigen::Vector3d n1 = (q[1] - q[0]).cross(q[2] - q[0]);
+        if (n1.squaredNorm() <= 1.0e-12 * n0.squaredNorm()) return false;
+        if (n0.dot(n1) <= 0.0) return false;
+      }
+    }
+    return true;
+  };
+
+  void collapse(int keep, int remove, const Eigen::Vector3d& p) {
+    // texcoord of keep in the chart of the removed faces
+    int keep_tex = -1;
+    for (int f : vfaces_[remove]) {
+      auto& t = tris_[f];
+      if (!hasVertex(t, keep)) continue;
+      if (!ttex_.empty())
+        for (int i = 0; i < 3; ++i)
+          if (t[i] == keep) keep_tex = ttex_[f][i];
+      alive_[f] = 0;
+      --n_faces_;
+    }
+    for (int f : vfaces_[remove]) {
+      if (!alive_[f]) continue;
+      auto& t = tris_[f];
+      for (int i = 0; i < 3; ++i) {
+        if (t[i] != remove) continue;
+        t[i] = keep;
+        if (!ttex_.empty() && (keep_tex >= 0) && !seam_[remove]) ttex_[f][i] = keep_tex;
+      }
+      vfaces_[keep].push_back(f);
+    }
+    vfaces_[remove].clear();
+    pruneFaces(keep);
+
+    points_[keep] = p;
+    quadrics_[keep] += quadrics_[remove];
+    boundary_[keep] |= boundary_[remove];
+    seam_[keep] |= seam_[remove];
+    removed_[remove] = 1;
+    --n_vertices_;
+    ++stamp_[keep];
+    ++stamp_[remove];
+
+    // new entries for the edges around keep
+    mark_id_ += 1;
+    for (int f : vfaces_[keep])
+      for (int w : tris_[f])
+        if ((w != keep) && (mark_[w] != mark_id_)) {
+          mark_[w] = mark_id_;
+          pushEdge(keep, w);
+        }
+  };
+};
+
+#endif // _MESHDECIMATORL_HXX
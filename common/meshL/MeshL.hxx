@@ -12,10 +12,12 @@
 
 #include "envDep.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <list>
-#include <map>
 #include <memory>
-#include <set>
+#include <unordered_map>
 #include <vector>
 //using namespace std;
 
@@ -32,84 +34,134 @@
 #include "BLoopL.hxx"
 #include "VertexLCirculator.hxx"
 #include "MeshUtiL.hxx"
+#include "MeshArena.hxx"
+#include "PropertyL.hxx"
+#include "ParallelFor.hxx"
 
 namespace meshl_detail {
 
-inline bool buildBoundaryAdjacency(
-    const std::list<std::shared_ptr<HalfedgeL>>& halfedges,
-    std::map<std::shared_ptr<VertexL>, std::vector<std::shared_ptr<VertexL>>>&
-        adjacency) {
-  adjacency.clear();
-  for (const auto& he : halfedges) {
-    if (!he->isBoundary()) continue;
-    const auto a = he->vertex();
-    const auto b = he->next()->vertex();
-    adjacency[a].push_back(b);
-    adjacency[b].push_back(a);
+// id -> element table kept alongside an element list of MeshL.
+// Entries are validated against id() on lookup, so a stale entry (id
+// changed through setID) only costs one rebuild from the list.
+template <class T>
+class IdIndex {
+
+ public:
+
+  void clear() {
+    table_.clear();
+    is_complete_ = true;
   }
-  return !adjacency.empty();
-}
 
-// Walk one boundary connected component containing start (counter-clockwise
-// order depends on halfedge orientation; order is consistent along the loop).
-inline bool collectOrderedBoundaryLoop(
-    const std::map<std::shared_ptr<VertexL>,
-                   std::vector<std::shared_ptr<VertexL>>>& adjacency,
-    std::shared_ptr<VertexL> start,
-    std::vector<std::shared_ptr<VertexL>>& loop_vertices) {
-  loop_vertices.clear();
-  if (start == nullptr) return false;
-  const auto start_it = adjacency.find(start);
-  if (start_it == adjacency.end()) return false;
-
-  std::shared_ptr<VertexL> prev = nullptr;
-  std::shared_ptr<VertexL> cur = start;
-  do {
-    loop_vertices.push_back(cur);
-    const auto it = adjacency.find(cur);
-    if (it == adjacency.end()) return false;
-
-    std::shared_ptr<VertexL> next = nullptr;
-    for (const auto& nb : it->second) {
-      if (nb != prev) {
-        next = nb;
-        break;
-      }
-    }
-    if (next == nullptr) return false;
+  // call after ids were assigned by hand (setID)
+  void invalidate() { is_complete_ = false; }
 
-    prev = cur;
-    cur = next;
-  } while (cur != start);
+  void reserve(size_t n) { table_.reserve(n); }
 
-  return loop_vertices.size() >= 3;
-}
+  void insert(const std::shared_ptr<T>& e) {
+    const int id = e->id();
+    if (id < 0) return;
+    if (id >= static_cast<int>(table_.size())) table_.resize(id + 1);
+    if (!table_[id] || table_[id]->id() != id) table_[id] = e;
+  }
+
+  void erase(const std::shared_ptr<T>& e) {
+    const int id = e->id();
+    if (id >= 0 && id < static_cast<int>(table_.size()) && table_[id] == e) {
+      table_[id].reset();
+    } else {
+      is_complete_ = false;
+    }
+  }
 
-inline int boundaryComponentSize(
-    const std::map<std::shared_ptr<VertexL>,
-                   std::vector<std::shared_ptr<VertexL>>>& adjacency,
-    std::shared_ptr<VertexL> start) {
-  if (start == nullptr || adjacency.find(start) == adjacency.end()) return 0;
-
-  std::set<std::shared_ptr<VertexL>> visited;
-  std::vector<std::shared_ptr<VertexL>> stack = {start};
-  while (!stack.empty()) {
-    const auto cur = stack.back();
-    stack.pop_back();
-    if (!visited.insert(cur).second) continue;
-    const auto it = adjacency.find(cur);
-    if (it == adjacency.end()) continue;
-    for (const auto& nb : it->second) {
-      if (!visited.count(nb)) stack.push_back(nb);
+  std::shared_ptr<T> find(int id, const std::list<std::shared_ptr<T>>& l) {
+    if (id >= 0 && id < static_cast<int>(table_.size())) {
+      const auto& e = table_[id];
+      if (e && e->id() == id) return e;
+      if (e) is_complete_ = false;
     }
+    if (is_complete_) return nullptr;
+    rebuild(l);
+    if (id < 0 || id >= static_cast<int>(table_.size())) return nullptr;
+    return table_[id];
   }
-  return static_cast<int>(visited.size());
+
+  // rebuild and release the memory of a larger table
+  void shrink(const std::list<std::shared_ptr<T>>& l) {
+    std::vector<std::shared_ptr<T>>().swap(table_);
+    rebuild(l);
+  }
+
+  // the first element with a given id wins (same as a linear search)
+  void rebuild(const std::list<std::shared_ptr<T>>& l) {
+    table_.clear();
+    for (const auto& e : l) insert(e);
+    is_complete_ = true;
+  }
+
+ private:
+
+  std::vector<std::shared_ptr<T>> table_;
+  bool is_complete_ = true;
+};
+
+// createConnectivity: packed (min, max) vertex key of a halfedge and its
+// position in face traversal order
+struct HalfedgeKey {
+  uint64_t key;
+  uint32_t seq;
+};
+
+inline bool operator<(const HalfedgeKey& a, const HalfedgeKey& b) {
+  return (a.key < b.key) || ((a.key == b.key) && (a.seq < b.seq));
 }
 
+// halfedges sharing a key (= one edge): first halfedge, and either -1
+// (the edge itself) or a halfedge paired with the first one
+struct HalfedgeGroup {
+  uint32_t first;
+  int32_t rhe;
+};
+
+struct ConnectivityWarning {
+  uint32_t seq;    // offending halfedge
+  uint32_t first;  // first halfedge of its edge
+  bool invalid;    // false: more than three halfedges, true: invalid pair
+};
+
 }  // namespace meshl_detail
 
+//
+// receives the edits of a MeshL while set with MeshL::setEditLog()
+// (see MeshTransactionL.hxx).  touch() is called with an element before
+// it is changed; added() after an element was appended to its list and
+// removing() before one is deleted.
+//
+class MeshEditLogL {
+
+ public:
+
+  virtual ~MeshEditLogL() {};
+
+  virtual void touch(const std::shared_ptr<VertexL>& vt) = 0;
+  virtual void touch(const std::shared_ptr<FaceL>& fc) = 0;
+  virtual void touch(const std::shared_ptr<HalfedgeL>& he) = 0;
+
+  virtual void added(const std::shared_ptr<VertexL>& vt) = 0;
+  virtual void added(const std::shared_ptr<FaceL>& fc) = 0;
+  virtual void added(const std::shared_ptr<HalfedgeL>& he) = 0;
+
+  virtual void removing(const std::shared_ptr<VertexL>& vt) = 0;
+  virtual void removing(const std::shared_ptr<FaceL>& fc) = 0;
+  virtual void removing(const std::shared_ptr<HalfedgeL>& he) = 0;
+};
+
+class MeshTransactionL;
+
 class MeshL {
 
+  friend class MeshTransactionL;
+
  public:
 
   MeshL() { init(); };
@@ -125,9 +177,90 @@ class MeshL {
     bl_id_ = 0;
     l_id_ = 0;
     isConnectivity_ = false;
+    topology_version_ = 0;
+    connectivity_version_ = 0;
+    isSmoothNormal_ = false;
+    vn_version_ = 0;
+    vn_all_moved_ = false;
+    vf_version_ = 0;
+    list_version_ = 1;
+    v_array_version_ = f_array_version_ = t_array_version_ = 0;
     isNormalized_ = false;
     texID_ = 0;
+    v_hint_ = n_hint_ = t_hint_ = h_hint_ = f_hint_ = e_hint_ = 0;
+  };
+
+  //
+  // allocation mode
+  //
+  // true: new elements (and their shared_ptr control blocks) are taken
+  // from a slab arena owned by this mesh (see MeshArena.hxx).
+  // Elements already created are not moved.
+  void setPoolAllocation(bool f) {
+    if (f && !arena_) arena_ = meshl_detail::ArenaRef(meshl_detail::MeshArena::create());
+    if (!f) arena_.reset();
+  };
+  bool isPoolAllocation() const { return (bool) arena_; };
+
+  // bytes reserved by the arena (0 if pool allocation is off)
+  size_t reservedBytes() const { return arena_ ? arena_->reservedBytes() : 0; };
+
+  // size hints for the next elements (slabs are pre-sized with pool
+  // allocation; id tables are pre-sized in both modes). negative counts
+  // are taken as 0
+  void reserve(int nv, int nf, int nh, int nt = 0, int nn = 0) {
+    nv = std::max(nv, 0); nf = std::max(nf, 0); nh = std::max(nh, 0);
+    nt = std::max(nt, 0); nn = std::max(nn, 0);
+    v_hint_ = nv; f_hint_ = nf; h_hint_ = nh; t_hint_ = nt; n_hint_ = nn;
+    v_index_.reserve(v_id_ + nv);
+    f_index_.reserve(f_id_ + nf);
+    h_index_.reserve(h_id_ + nh);
+    t_index_.reserve(t_id_ + nt);
+    n_index_.reserve(n_id_ + nn);
+  };
+
+  //
+  // per-element properties (see PropertyL.hxx)
+  //
+  // Dense arrays indexed by element id.  add*Property returns the
+  // existing property if one with the same name and type is there
+  // (nullptr if the type differs).
+  //
+  // std::shared_ptr<PropertyL<int> > idx = mesh.addVertexProperty<int>("idx", -1);
+  // (*idx)[vt] = 3;
+  template <class T>
+  std::shared_ptr<PropertyL<T> > addVertexProperty(const std::string& name, const T& init = T()) {
+    return v_props_.add<T>(name, init, v_id_);
+  };
+  template <class T>
+  std::shared_ptr<PropertyL<T> > vertexProperty(const std::string& name) const {
+    return v_props_.get<T>(name);
+  };
+  bool removeVertexProperty(const std::string& name) { return v_props_.remove(name); };
+
+  template <class T>
+  std::shared_ptr<PropertyL<T> > addFaceProperty(const std::string& name, const T& init = T()) {
+    return f_props_.add<T>(name, init, f_id_);
+  };
+  template <class T>
+  std::shared_ptr<PropertyL<T> > faceProperty(const std::string& name) const {
+    return f_props_.get<T>(name);
+  };
+  bool removeFaceProperty(const std::string& name) { return f_props_.remove(name); };
+
+  template <class T>
+  std::shared_ptr<PropertyL<T> > addHalfedgeProperty(const std::string& name, const T& init = T()) {
+    return h_props_.add<T>(name, init, h_id_);
+  };
+  template <class T>
+  std::shared_ptr<PropertyL<T> > halfedgeProperty(const std::string& name) const {
+    return h_props_.get<T>(name);
   };
+  bool removeHalfedgeProperty(const std::string& name) { return h_props_.remove(name); };
+
+  PropertyRegistryL& vertexProperties() { return v_props_; };
+  PropertyRegistryL& faceProperties() { return f_props_; };
+  PropertyRegistryL& halfedgeProperties() { return h_props_; };
 
   // elements
   std::list<std::shared_ptr<VertexL> >& vertices() { return vertices_; };
@@ -146,9 +279,7 @@ class MeshL {
 
   // vertex
   std::shared_ptr<VertexL> vertex(int id) {
-    for (auto& vt : vertices_)
-      if (vt->id() == id) return vt;
-    return nullptr;
+    return v_index_.find(id, vertices_);
   };
 
   std::shared_ptr<VertexL> addVertex(Eigen::Vector3d& p) {
@@ -158,15 +289,16 @@ class MeshL {
   };
 
   void deleteVertex(std::shared_ptr<VertexL> vt) {
+    if (edit_log_) edit_log_->removing(vt);
+    touchTopology();
+    v_index_.erase(vt);
     vertices_.erase(vt->iter());
     //delete vt;
   };
 
   // normal
   std::shared_ptr<NormalL> normal(int id) {
-    for (auto& nm : normals_)
-      if (nm->id() == id) return nm;
-    return nullptr;
+    return n_index_.find(id, normals_);
   };
 
   std::shared_ptr<NormalL> addNormal(Eigen::Vector3d& p) {
@@ -176,15 +308,16 @@ class MeshL {
   };
 
   void deleteNormal(std::shared_ptr<NormalL> nm) {
+    n_index_.erase(nm);
     normals_.erase(nm->iter());
+    // owned smooth normals are rebuilt by the next calcSmoothVertexNormal()
+    vnormal_.clear();
     //delete nm;
   }
 
   // texcoord
   std::shared_ptr<TexcoordL> texcoord(int id) {
-    for (auto& tc : texcoords_)
-      if (tc->id() == id) return tc;
-    return nullptr;
+    return t_index_.find(id, texcoords_);
   };
 
   std::shared_ptr<TexcoordL> addTexcoord(Eigen::Vector3d& p) {
@@ -194,18 +327,19 @@ class MeshL {
   };
 
   void deleteTexcoord(std::shared_ptr<TexcoordL> tc) {
+    ++list_version_;
+    t_index_.erase(tc);
     texcoords_.erase(tc->iter());
     //delete tc;
   };
 
   // halfedge
   std::shared_ptr<HalfedgeL> halfedge(int id) {
-    for (auto& he : halfedges_)
-      if (he->id() == id) return he;
-    return nullptr;
+    return h_index_.find(id, halfedges_);
   };
 
   std::shared_ptr<HalfedgeL> addHalfedge(std::shared_ptr<FaceL> fc) {
+    if (edit_log_) edit_log_->touch(fc);
     std::shared_ptr<HalfedgeL> he = addHalfedge();
     fc->addHalfedge(he);
     return he;
@@ -215,6 +349,10 @@ class MeshL {
                                          std::shared_ptr<VertexL> vt,
                                          std::shared_ptr<NormalL> nm = nullptr,
                                          std::shared_ptr<TexcoordL> tc = nullptr) {
+    if (edit_log_) {
+      edit_log_->touch(fc);
+      if (vt) edit_log_->touch(vt);
+    }
     std::shared_ptr<HalfedgeL> he = addHalfedge();
     fc->addHalfedge(he, vt, nm, tc);
     return he;
@@ -226,6 +364,10 @@ class MeshL {
                                             std::shared_ptr<VertexL> vt,
                                             std::shared_ptr<NormalL> nm = nullptr,
                                             std::shared_ptr<TexcoordL> tc = nullptr) {
+    if (edit_log_) {
+      edit_log_->touch(fc);
+      if (vt) edit_log_->touch(vt);
+    }
     std::shared_ptr<HalfedgeL> nhe = addHalfedge();
     fc->insertHalfedge(nhe, he, vt, nm, tc);
     return nhe;
@@ -234,6 +376,8 @@ class MeshL {
   // 不要なhalfedgeを削除
   void deleteHalfedge(std::shared_ptr<HalfedgeL> he) {
     if (!he) return;
+    if (edit_log_) edit_log_->removing(he);
+    touchTopology();
     
     // 削除前に参照をクリア
     if (he->vertex() && he->vertex()->halfedge() == he) {
@@ -254,6 +398,7 @@ class MeshL {
     
     // 全体リストからも削除（イテレータが有効な場合のみ）
     if (he->meshIter() != halfedges_.end()) {
+      h_index_.erase(he);
       halfedges_.erase(he->meshIter());
     }
 
@@ -266,21 +411,25 @@ class MeshL {
 
   // face
   std::shared_ptr<FaceL> face(int id) {
-    for (auto& fc : faces_)
-      if (fc->id() == id) return fc;
-    return nullptr;
+    return f_index_.find(id, faces_);
   };
 
   std::shared_ptr<FaceL> addFace() {
     int32_t id = f_id_++;
-    std::shared_ptr<FaceL> fc = std::make_shared<FaceL>(id);
+    std::shared_ptr<FaceL> fc = newElement<FaceL>(id, f_hint_);
     fc->setIter(faces_.insert(faces_.end(), fc));
+    f_index_.insert(fc);
+    touchTopology();
+    if (edit_log_) edit_log_->added(fc);
     return fc;
   };
   
   void deleteFace(std::shared_ptr<FaceL> fc) {
     if (fc == nullptr) return;
+    if (edit_log_) edit_log_->removing(fc);
+    touchTopology();
     fc->deleteHalfedges();
+    f_index_.erase(fc);
     faces_.erase(fc->iter());
     //delete fc;
   };
@@ -307,6 +456,49 @@ class MeshL {
     return fc;
   };
 
+  //
+  // bulk construction from flat arrays (appended to the mesh)
+  //
+  // points : 3 * n_vertices coordinates (x0 y0 z0 x1 ...)
+  // indices: vertex indices of all faces. face f uses
+  //          indices[offsets[f]] .. indices[offsets[f+1] - 1]
+  //          (offsets: n_faces + 1 entries, offsets[0] = 0).
+  //          offsets == nullptr: triangles, 3 * n_faces indices
+  // isCreateConnectivity: pair mates in the same pass
+  // returns false (and adds nothing) when an index is out of range or
+  // a face has fewer than 3 vertices
+  bool buildFromArrays(const double* points, int n_vertices,
+                       const int* indices, int n_faces,
+                       const int* offsets = nullptr,
+                       bool isCreateConnectivity = true) {
+    return buildFromArraysT(
+        n_vertices,
+        [points](int i) {
+          return Eigen::Vector3d(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+        },
+        n_faces, offsets, [indices](size_t k) { return indices[k]; },
+        isCreateConnectivity);
+  };
+
+  // V: n x 3 points, F: m x k faces (k >= 3, one polygon size)
+  bool buildFromArrays(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F,
+                       bool isCreateConnectivity = true) {
+    if ((V.rows() > 0) && (V.cols() < 3)) return false;
+    if ((F.rows() > 0) && (F.cols() < 3)) return false;
+    const int k = (int) F.cols();
+    std::vector<int> offsets;
+    if (k != 3) {
+      offsets.resize(F.rows() + 1);
+      for (int f = 0; f <= F.rows(); ++f) offsets[f] = f * k;
+    }
+    return buildFromArraysT(
+        (int) V.rows(),
+        [&V](int i) { return Eigen::Vector3d(V(i, 0), V(i, 1), V(i, 2)); },
+        (int) F.rows(), offsets.empty() ? nullptr : offsets.data(),
+        [&F, k](size_t j) { return F((Eigen::Index) (j / k), (Eigen::Index) (j % k)); },
+        isCreateConnectivity);
+  };
+
   // edge
   std::shared_ptr<EdgeL> addEdge(std::shared_ptr<VertexL> sv, std::shared_ptr<VertexL> ev) {
     std::shared_ptr<EdgeL> ed = addEdge();
@@ -339,6 +531,20 @@ class MeshL {
     return blp;
   }
 
+  // boundary loop from its halfedges in walking order
+  std::shared_ptr<BLoopL> addBLoop(const std::vector<HalfedgeL*>& loop) {
+    std::shared_ptr<BLoopL> bl = addBLoop();
+    for (HalfedgeL* he : loop) {
+      bl->addVertex(he->vertex());
+      bl->addHalfedge(he->shared_from_this());
+      bl->addIsCorner(false);
+    }
+
+    bl->setCorner(0, true);
+    bl->optimize(4);
+    return bl;
+  }
+
   void deleteBLoop(std::shared_ptr<BLoopL> blp) {
     bloops_.erase(blp->biter());
   }
@@ -348,25 +554,46 @@ class MeshL {
 
   // delete all
   void deleteAllVertices() {
+    touchTopology();
+    v_index_.clear();
     vertices_.clear();
   };
 
   void deleteAllNormals() {
+    n_index_.clear();
     normals_.clear();
+    isSmoothNormal_ = false;
+    vnormal_.clear();
   };
 
   void deleteAllTexcoords() {
+    ++list_version_;
+    t_index_.clear();
     texcoords_.clear();
   };
 
   void deleteAllHalfedges() {
+    touchTopology();
+    h_index_.clear();
     halfedges_.clear();
   };
 
   void deleteAllFaces() {
+    touchTopology();
+    f_index_.clear();
     faces_.clear();
   };
 
+  // id lookup tables (vertex(id), face(id), ...)
+  // call after assigning ids by hand through setID()
+  void invalidateIDIndex() {
+    v_index_.invalidate();
+    n_index_.invalidate();
+    t_index_.invalidate();
+    h_index_.invalidate();
+    f_index_.invalidate();
+  };
+
   void deleteAllEdges() {
     for (auto& ed : edges_) {
           if (ed->lhe() != nullptr) ed->lhe()->setEdge(nullptr);
@@ -420,9 +647,10 @@ class MeshL {
     return nullptr;
   }
 
+  // isolated vertices (no halfedge) are skipped
   std::shared_ptr<VertexL> findBoundaryVertex() {
     for (auto& vt : vertices_) {
-      if (isBoundary(vt) == true) return vt;
+      if ((vt->halfedgeRaw() != nullptr) && (isBoundary(vt) == true)) return vt;
     }
     return nullptr;
   }
@@ -441,61 +669,148 @@ class MeshL {
   static bool connectivityWarnings() { return connectivity_warnings_; }
 
   // create
+  // pair halfedges (mates) by sorting packed (min, max) vertex keys.
+  // Halfedges of one edge are visited in face order, so mates, warnings
+  // and (if !isDeleteEdges) edge ids are the same as with per-vertex
+  // edge lists.
   void createConnectivity(bool isDeleteEdges=true) {
+    // mates are valid for this topology: nothing to do
+    if (isConnectivity() && (connectivity_version_ == topology_version_)) {
+      if (isDeleteEdges) {
+        if (!(edges_.empty())) deleteAllEdges();
+        return;
+      }
+      if (!(edges_.empty())) return;
+    }
+
     // already defined
     if (isConnectivity()) {
       if (!(edges_.empty())) deleteAllEdges();
       deleteConnectivity();
     }
+    std::vector<const std::shared_ptr<HalfedgeL>*> hes;
+    std::vector<uint32_t> sv, nx;
+    bool isIndexID;
+    const size_t nv = collectHalfedgeVertexIndices(hes, sv, nx, isIndexID);
+    pairHalfedges(hes, sv, nx, nv, isIndexID, isDeleteEdges);
+  };
 
-    std::vector<EdgeList> edge_list(vertices_size());
-    for (auto& fc : faces_) {
-      for (auto& he : fc->halfedges()) {
-        auto sv = he->vertex();
-        auto ev = he->next()->vertex();
-
-        // set a halfedge to sv
-        sv->setHalfedge(he);
-
-        // find an edge
-        std::shared_ptr<EdgeL> ed = nullptr;
-        if ((ed = edge_list[sv->id()].findEdge(sv, ev)) == nullptr) {
-          // new edge
-          ed = addEdge(sv, ev);
-          ed->setLHalfedge(he);
-          edge_list[ed->sv()->id()].push_back(ed);
-          edge_list[ed->ev()->id()].push_back(ed);
-        } else {
-          if (ed->rhe() != nullptr) {
-            if (connectivity_warnings_) {
-              std::cerr << "Warning: More than three halfedges. Edge No."
-                        << ed->id() << std::endl;
-              std::cerr << "fc " << fc->id() << " he " << he->id()
-                        << std::endl;
-            }
-          }
-
-          // assign right halfedge
-          std::shared_ptr<HalfedgeL> lhe = ed->lhe();
-          if (lhe->mate_valid(he)) {
-            lhe->setMate(he);
-            he->setMate(lhe);
-          } else {
-            if (connectivity_warnings_) {
-              std::cerr << "Warning: invalid halfedge pair. Edge No." << ed->id()
-                        << std::endl;
-            }
-          }
-
-          if (ed->rhe_valid(he)) {
-            ed->setRHalfedge(he);
+  // pair halfedges given in face order.
+  // sv: origin vertex index in [0, nv), nx: index of the next halfedge.
+  // isIndexID: vertex index = vertex id (otherwise position in vertices_)
+  // sets mates, vertex halfedges and (if !isDeleteEdges) edges
+  void pairHalfedges(const std::vector<const std::shared_ptr<HalfedgeL>*>& hes,
+                     const std::vector<uint32_t>& sv,
+                     const std::vector<uint32_t>& nx,
+                     size_t nv, bool isIndexID, bool isDeleteEdges) {
+    const int e_base = e_id_;
+    const size_t nh = hes.size();
+
+    std::vector<uint32_t> ev(nh);
+    par_util::parallelFor(0, nh, [&](size_t i) { ev[i] = sv[nx[i]]; });
+
+    std::vector<meshl_detail::HalfedgeKey> keys(nh);
+    par_util::parallelFor(0, nh, [&](size_t i) {
+      const uint64_t a = sv[i], b = ev[i];
+      keys[i].key = (a < b) ? ((a << 32) | b) : ((b << 32) | a);
+      keys[i].seq = (uint32_t) i;
+    });
+    par_util::parallelSort(keys, std::less<meshl_detail::HalfedgeKey>());
+
+    // scan groups of equal keys; chunk bounds are moved to group starts
+    const int nchunks = par_util::numChunks(nh, 1 << 14);
+    std::vector<std::vector<meshl_detail::ConnectivityWarning>> warnings(nchunks);
+    std::vector<std::vector<meshl_detail::HalfedgeGroup>> groups(nchunks);
+    std::vector<int32_t> mate(nh, -1);
+    auto group_start = [&](size_t i) {
+      while ((i > 0) && (i < nh) && (keys[i].key == keys[i - 1].key)) ++i;
+      return i;
+    };
+    const bool warn = connectivity_warnings_;
+    par_util::forChunks(nh, nchunks, [&](size_t b, size_t e, int c) {
+      b = group_start(b);
+      e = group_start(e);
+      size_t i = b;
+      while (i < e) {
+        const uint32_t h0 = keys[i].seq;
+        int32_t rhe = -1;
+        if (!isDeleteEdges) groups[c].push_back({ h0, -1 });
+        size_t j = i + 1;
+        for (; (j < e) && (keys[j].key == keys[i].key); ++j) {
+          const uint32_t hk = keys[j].seq;
+          if ((rhe >= 0) && warn) warnings[c].push_back({ hk, h0, false });
+          if ((sv[h0] == ev[hk]) && (ev[h0] == sv[hk])) {
+            (*hes[h0])->setMate(*hes[hk]);
+            (*hes[hk])->setMate(*hes[h0]);
+            mate[h0] = (int32_t) hk;
+            mate[hk] = (int32_t) h0;
+            rhe = (int32_t) hk;
+            if (!isDeleteEdges) groups[c].push_back({ h0, rhe });
+          } else if (warn) {
+            warnings[c].push_back({ hk, h0, true });
           }
         }
+        i = j;
       }
+    });
+
+    // halfedges left unpaired are boundary
+    par_util::parallelFor(0, nh, [&](size_t i) {
+      if ((mate[i] < 0) && !((*hes[i])->isBoundary())) (*hes[i])->setMate(nullptr);
+    });
+
+    if (warn) reportConnectivityWarnings(hes, keys, warnings, e_base);
+
+    // edges in order of their first halfedge. every paired halfedge is
+    // set as rhe in turn, the last one stays.
+    if (!isDeleteEdges) {
+      std::vector<meshl_detail::HalfedgeGroup> all;
+      for (auto& g : groups) all.insert(all.end(), g.begin(), g.end());
+      std::stable_sort(all.begin(), all.end(),
+                       [](const meshl_detail::HalfedgeGroup& a,
+                          const meshl_detail::HalfedgeGroup& b) { return a.first < b.first; });
+      // slab hint: one edge per group without rhe
+      e_hint_ = (size_t) std::count_if(all.begin(), all.end(),
+                                       [](const meshl_detail::HalfedgeGroup& g) { return g.rhe < 0; });
+      std::shared_ptr<EdgeL> ed = nullptr;
+      for (auto& g : all) {
+        if (g.rhe < 0) {
+          const std::shared_ptr<HalfedgeL>& lhe = *hes[g.first];
+          ed = addEdge(lhe->vertex(), lhe->next()->vertex());
+          ed->setLHalfedge(lhe);
+        } else {
+          ed->setRHalfedge(*hes[g.rhe]);
+        }
+      }
+    }
+
+    // a vertex keeps its last outgoing halfedge in face order, moved to
+    // the end. (efficient for boundary vertex; the walk of
+    // HalfedgeL::reset() done on the index arrays)
+    std::vector<int32_t> last(nv, -1);
+    for (size_t i = 0; i < nh; ++i) last[sv[i]] = (int32_t) i;
+    par_util::parallelFor(0, nv, [&](size_t v) {
+      int32_t h = last[v];
+      if ((h < 0) || (mate[h] < 0)) return;
+      const int32_t start = h;
+      size_t steps = 0;
+      do {
+        h = (int32_t) nx[mate[h]];
+      } while ((mate[h] >= 0) && (h != start) && (++steps < nh));
+      last[v] = h;
+    });
+    for (size_t v = 0; v < nv; ++v) {
+      if (last[v] < 0) continue;
+      const std::shared_ptr<HalfedgeL>& he = *hes[last[v]];
+      he->vertex()->setHalfedge(he);
     }
 
-    // move vt's halfedge to the end. (efficient for boundary vertex)
+    // vertices without faces keep their halfedge (moved to the end)
+    int pos = 0;
     for (auto& vt : vertices_) {
+      const int v = isIndexID ? vt->id() : pos;
+      ++pos;
+      if (last[v] >= 0) continue;
       auto he = vt->halfedge();
       if (he != nullptr) vt->setHalfedge(he->reset());
     }
@@ -550,10 +865,11 @@ class MeshL {
 
   // delete unused vertices
   void deleteIsolateVertices() {
+    // ids may be sparse after deletions
     std::vector<int> vcount;
-    vcount.resize(vertices_size());
+    vcount.resize(v_id_);
 
-    unsigned int v_size = vertices_size();
+    unsigned int v_size = v_id_;
     unsigned int i;
     for (i = 0; i < v_size; ++i) vcount[i] = 0;
 
@@ -565,7 +881,7 @@ class MeshL {
 
     bool isRecalculateBLoop = false;
     for (i = 0; i < v_size; ++i)
-      if (!(vcount[i])) {
+      if (!(vcount[i]) && vertex(i)) {
         std::cout << "Warning: Vertex No." << i
                   << " was not used in all faces. deleted..." << std::endl;
         auto vt = vertex(i);
@@ -612,6 +928,7 @@ class MeshL {
 
   // 全faceのhalfedgeリストを再構築（nullptr参照を除外）
   void rebuildAllFaceHalfedgeLists() {
+    touchTopology();
     for (auto& fc : faces_) {
       std::list<std::shared_ptr<HalfedgeL>> valid_halfedges;
       for (auto& he : fc->halfedges()) {
@@ -628,31 +945,68 @@ class MeshL {
   }
 
   bool isConnectivity() const { return isConnectivity_; };
-  void setConnectivity(bool f) { isConnectivity_ = f; };
+  // setConnectivity(true): the current mates are declared valid for the
+  // current topology (createConnectivity(true) will not rebuild them)
+  void setConnectivity(bool f) {
+    isConnectivity_ = f;
+    if (f) connectivity_version_ = topology_version_;
+  };
+
+  //
+  // topology version
+  //
+  // bumped by addFace/deleteFace, halfedge insertion/deletion, vertex
+  // deletion, reordering and deleteAll. Code that rewires halfedges by
+  // hand (HalfedgeL::setVertex, FaceL::addHalfedge, ...) must call
+  // touchTopology() so that createConnectivity() rebuilds the mates.
+  uint64_t topologyVersion() const { return topology_version_; };
+  void touchTopology() { ++topology_version_; ++list_version_; };
+
+  //
+  // edit log (nullptr: none)
+  //
+  // addVertex/addFace/addHalfedge and deleteVertex/deleteFace/
+  // deleteHalfedge report to the log; code that changes elements
+  // calls editLog()->touch() first (EulerOperations does).
+  void setEditLog(MeshEditLogL* log) { edit_log_ = log; };
+  MeshEditLogL* editLog() const { return edit_log_; };
 
   //
   // 折れ線を考慮していないスムースシェーディング用
   // (ハーフエッジを使わない例)
   //
+  // Normals read from a file are kept as they are. Normals made here are
+  // owned by the mesh: later calls only update them in place around
+  // vertices marked by markVertexMoved(), and rebuild them after a
+  // topology change.
+  //
   void calcSmoothVertexNormal() {
 
-    if (normals_.size()) return;
+    if (normals_.size()) {
+      if (!isSmoothNormal_) return;
+      if (!vnormal_.empty() && (vn_version_ == topology_version_)) {
+        updateSmoothVertexNormals();
+        return;
+      }
+      deleteAllNormals();
+    }
+    if (vn_all_moved_ || !v_moved_.empty()) calcAllFaceNormals();
+    if (isParallelPass(faces_.size())) {
+      calcSmoothVertexNormalParallel();
+      return;
+    }
 
-    // 面の数 保存用
-    std::vector<int> n_vf;
-    n_vf.resize(vertices_size());
+    // id の範囲
+    const int n = vertexIDRange();
+    std::vector<char> present(n, 0);
+    for (auto& vt : vertices_) present[vt->id()] = 1;
 
+    // 面の数 保存用
+    std::vector<int> n_vf(n, 0);
     // 面積計算用
-    std::vector<double> area(vertices_size());
+    std::vector<double> area(n, 0.0);
     // normal 計算用
-    std::vector<Eigen::Vector3d> nmvec(vertices_size());
-
-    // 初期化
-    // id の付け直し
-    for (int i = 0; i < vertices_size(); ++i) {
-      n_vf[i] = 0;
-      nmvec[i] = Eigen::Vector3d::Zero();
-    }
+    std::vector<Eigen::Vector3d> nmvec(n, Eigen::Vector3d::Zero());
 
     for (auto& fc : faces_) {
       double a = fc->area();
@@ -665,24 +1019,106 @@ class MeshL {
       }
     }
 
-    std::vector<std::shared_ptr<NormalL>> nm_array;
-    nm_array.resize(vertices_size());
-    for (int i = 0; i < vertices_size(); ++i) {
+    vnormal_.assign(n, nullptr);
+    for (int i = 0; i < n; ++i) {
+      if (!present[i]) continue;
       double f = (double)n_vf[i];
       nmvec[i] /= (f * area[i]);
       nmvec[i].normalize();
-      auto nm = addNormal(nmvec[i]);
-      nm_array[i] = nm;
+      vnormal_[i] = addNormal(nmvec[i]);
     }
 
     for (auto& fc : faces_) {
       for (auto& he : fc->halfedges()) {
-        he->setNormal(nm_array[he->vertex()->id()]);
+        he->setNormal(vnormal_[he->vertex()->id()]);
+      }
+    }
+
+    isSmoothNormal_ = true;
+    vn_version_ = topology_version_;
+    clearMovedVertices();
+  };
+
+  // vertex positions changed by hand (VertexL::setPoint): the normals of
+  // their one-rings are recomputed by the next calcSmoothVertexNormal()
+  void markVertexMoved(const std::shared_ptr<VertexL>& vt) { markVertexMoved(vt->id()); };
+  void markVertexMoved(int id) {
+    if (id < 0) return;
+    if (id >= (int) v_moved_flag_.size()) v_moved_flag_.resize(id + 1, 0);
+    if (v_moved_flag_[id]) return;
+    v_moved_flag_[id] = 1;
+    v_moved_.push_back(id);
+  };
+  // every vertex moved (all face normals are recomputed as well)
+  void markAllVerticesMoved() { vn_all_moved_ = true; };
+
+  // update owned smooth normals around moved vertices: normals of the
+  // faces incident to them, then normals of the vertices of those faces.
+  // returns the number of vertex normals recomputed
+  int updateSmoothVertexNormals() {
+    if (!isSmoothNormal_ || normals_.empty()) {
+      clearMovedVertices();
+      return 0;
+    }
+    if (vnormal_.empty() || (vn_version_ != topology_version_)) {
+      calcSmoothVertexNormal();
+      return (int) vertices_.size();
+    }
+    if (vn_all_moved_) {
+      calcAllFaceNormals();
+      buildVertexFaces();
+      const std::vector<VertexL*>& va = vertexArray();
+      par_util::parallelFor(0, va.size(), [&](size_t i) {
+        updateSmoothVertexNormal(va[i]->id());
+      }, kParallelGrain);
+      clearMovedVertices();
+      return (int) va.size();
+    }
+    if (v_moved_.empty()) return 0;
+
+    buildVertexFaces();
+    const int nv = (int) vf_offset_.size() - 1;
+    if ((int) f_dirty_.size() < f_id_) f_dirty_.resize(f_id_, 0);
+    if ((int) v_dirty_.size() < nv) v_dirty_.resize(nv, 0);
+
+    // faces around moved vertices
+    dirty_faces_.clear();
+    for (int id : v_moved_) {
+      if (id >= nv) continue;
+      for (int k = vf_offset_[id]; k < vf_offset_[id + 1]; ++k) {
+        FaceL* fc = vf_faces_[k];
+        if (f_dirty_[fc->id()]) continue;
+        f_dirty_[fc->id()] = 1;
+        dirty_faces_.push_back(fc);
+      }
+    }
+
+    // vertices of those faces
+    dirty_vertices_.clear();
+    for (FaceL* fc : dirty_faces_) {
+      fc->calcNormal();
+      f_dirty_[fc->id()] = 0;
+      for (auto& he : fc->halfedges()) {
+        const int id = he->vertex()->id();
+        if (v_dirty_[id]) continue;
+        v_dirty_[id] = 1;
+        dirty_vertices_.push_back(id);
       }
     }
+    for (int id : dirty_vertices_) {
+      updateSmoothVertexNormal(id);
+      v_dirty_[id] = 0;
+    }
+
+    clearMovedVertices();
+    return (int) dirty_vertices_.size();
   };
 
   void computeBB( Eigen::Vector3d& bbmin, Eigen::Vector3d& bbmax ) {
+    if (isParallelPass(vertices_.size())) {
+      parallelBB(vertexArray(), bbmin, bbmax);
+      return;
+    }
     int i = 0;
     for (auto& vt : vertices_) {
       Eigen::Vector3d& p = vt->point();
@@ -702,6 +1138,15 @@ class MeshL {
   };
 
   void normalize(Eigen::Vector3d& center, double maxlen) {
+    if (isParallelPass(vertices_.size())) {
+      const std::vector<VertexL*>& va = vertexArray();
+      par_util::parallelFor(0, va.size(), [&](size_t i) {
+        Eigen::Vector3d p1 = va[i]->point() - center;
+        p1 /= maxlen;
+        va[i]->setPoint(p1);
+      }, kParallelGrain);
+      return;
+    }
     for (auto& vt : vertices_) {
       Eigen::Vector3d p1 = vt->point() - center;
       p1 /= maxlen;
@@ -714,22 +1159,7 @@ class MeshL {
 
     std::cout << "normalize ... ";
     Eigen::Vector3d vmax, vmin;
-    int i = 0;
-    for (auto& vt : vertices_) {
-      Eigen::Vector3d& p = vt->point();
-      if (i) {
-        if (p.x() > vmax.x()) vmax.x() = p.x();
-        if (p.x() < vmin.x()) vmin.x() = p.x();
-        if (p.y() > vmax.y()) vmax.y() = p.y();
-        if (p.y() < vmin.y()) vmin.y() = p.y();
-        if (p.z() > vmax.z()) vmax.z() = p.z();
-        if (p.z() < vmin.z()) vmin.z() = p.z();
-      } else {
-        vmax = p;
-        vmin = p;
-      }
-      ++i;
-    }
+    computeBB(vmin, vmax);
 
     center_ = (vmax + vmin) * .5;
 
@@ -752,11 +1182,22 @@ class MeshL {
 
     std::cout << "unnormalize ... ";
 
-    for (auto& vt : vertices_) {
-      Eigen::Vector3d p(vt->point());
-      p *= maxLength();
-      p += center_;
-      vt->setPoint(p);
+    if (isParallelPass(vertices_.size())) {
+      const std::vector<VertexL*>& va = vertexArray();
+      const double maxl = maxLength();
+      par_util::parallelFor(0, va.size(), [&](size_t i) {
+        Eigen::Vector3d p(va[i]->point());
+        p *= maxl;
+        p += center_;
+        va[i]->setPoint(p);
+      }, kParallelGrain);
+    } else {
+      for (auto& vt : vertices_) {
+        Eigen::Vector3d p(vt->point());
+        p *= maxLength();
+        p += center_;
+        vt->setPoint(p);
+      }
     }
 
     setIsNormalized(false);
@@ -766,6 +1207,19 @@ class MeshL {
 
   // void normalizeTexcoord();
   void normalizeTexcoord() {
+    if (isParallelPass(texcoords_.size())) {
+      const std::vector<TexcoordL*>& ta = texcoordArray();
+      Eigen::Vector3d bmin, bmax;
+      parallelBB(ta, bmin, bmax);
+      const double xlen = bmax.x() - bmin.x();
+      const double ylen = bmax.y() - bmin.y();
+      par_util::parallelFor(0, ta.size(), [&](size_t i) {
+        Eigen::Vector3d& p = ta[i]->point();
+        Eigen::Vector3d q((p.x() - bmin.x()) / xlen, (p.y() - bmin.y()) / ylen, .0);
+        ta[i]->setPoint(q);
+      }, kParallelGrain);
+      return;
+    }
     Eigen::Vector2d vmax, vmin;
     int i = 0;
     for (auto& tc : texcoords_) {
@@ -794,6 +1248,12 @@ class MeshL {
   };
 
   void calcAllFaceNormals() {
+    if (isParallelPass(faces_.size())) {
+      const std::vector<FaceL*>& fa = faceArray();
+      par_util::parallelFor(0, fa.size(), [&](size_t i) { fa[i]->calcNormal(); },
+                            kParallelGrain);
+      return;
+    }
     for (auto& fc : faces_)
       fc->calcNormal();
   };
@@ -813,38 +1273,54 @@ class MeshL {
   void createBLoop(std::shared_ptr<VertexL> sv) {
     createConnectivity(true);
 
+    if ((sv == nullptr) || (sv->halfedgeRaw() == nullptr)) return;
     if (isBoundary(sv) == false) return;
 
     if (!(emptyBLoop())) deleteAllBLoops();
 
-    std::map<std::shared_ptr<VertexL>, std::vector<std::shared_ptr<VertexL>>>
-        adjacency;
-    if (!meshl_detail::buildBoundaryAdjacency(halfedges_, adjacency)) return;
+    // boundary halfedge leaving sv
+    HalfedgeL* start = sv->halfedgeRaw();
+    while (start->mateRaw() != nullptr) {
+      start = start->mateRaw()->nextRaw();
+      if (start == sv->halfedgeRaw()) return;
+    }
 
-    std::vector<std::shared_ptr<VertexL>> loop_vertices;
-    if (!meshl_detail::collectOrderedBoundaryLoop(adjacency, sv, loop_vertices)) {
+    std::vector<HalfedgeL*> loop;
+    HalfedgeL* he = start;
+    do {
+      loop.push_back(he);
+      he = nextBoundaryHalfedge(he);
+      if (loop.size() > halfedges_.size()) he = nullptr;
+    } while ((he != nullptr) && (he != start));
+    if (he == nullptr) {
       std::cerr << "createBLoop: failed to walk boundary loop from vertex "
                 << sv->id() << std::endl;
       return;
     }
+    if (loop.size() < 3) return;
 
-    const int component_size =
-        meshl_detail::boundaryComponentSize(adjacency, sv);
-    if (static_cast<int>(loop_vertices.size()) != component_size) {
-      std::cerr << "createBLoop: incomplete loop (" << loop_vertices.size()
-                << " of " << component_size << " boundary vertices)."
-                << std::endl;
-      return;
-    }
+    addBLoop(loop);
+  }
 
-    std::shared_ptr<BLoopL> bl = addBLoop();
-    for (const auto& vt : loop_vertices) {
-      bl->addVertex(vt);
-      bl->addIsCorner(false);
-    }
+  //
+  // create all boundary loops (one BLoopL each, longest first) in one
+  // walk over the boundary halfedges; returns the number of loops
+  //
+  int createAllBLoops() {
+    createConnectivity(true);
 
-    bl->setCorner(0, true);
-    bl->optimize(4);
+    if (!(emptyBLoop())) deleteAllBLoops();
+
+    std::vector<std::vector<HalfedgeL*>> loops;
+    collectBoundaryLoops(halfedges_, loops);
+    std::stable_sort(loops.begin(), loops.end(),
+                     [](const std::vector<HalfedgeL*>& a,
+                        const std::vector<HalfedgeL*>& b) { return a.size() > b.size(); });
+    for (const auto& loop : loops) {
+      if (loop.size() < 3) continue;
+      addBLoop(loop);
+    }
+    return (int) bloops_.size();
   }
 
   bool isVerticesSelected() {
@@ -877,44 +1353,101 @@ class MeshL {
   };
 
   //
-  // create a new mesh with reordering vertices according to an array "order"
+  // reorder vertices according to an array "order"
+  // (order[i]: list position of the vertex that comes i-th)
+  //
+  // Vertices are moved within the list (halfedges, colors and flags
+  // are kept) and renumbered 0 .. n-1; vertex properties follow.
   //
   void reorderVertices(std::vector<int>& order) {
     int n_vt = vertices_.size();
+    if ((int) order.size() != n_vt) return;
 
-    // store old vertices
-    std::vector<std::shared_ptr<VertexL> > old_vt;
-    int id = 0;
-    for (auto& vt : vertices_) {
-      old_vt.push_back(vt);
-      vt->setID(id++);
-    }
-
-    // create vertices according to the order array and add vertex lists
-    std::vector<std::shared_ptr<VertexL> > new_vt;
-    id = 0;
-    std::vector<int> new_id(n_vt);
+    std::vector<std::shared_ptr<VertexL> > old_vt(vertices_.begin(), vertices_.end());
+    std::vector<int> new_id(v_id_, -1);
+    touchTopology();
     for (int i = 0; i < n_vt; ++i) {
-      std::shared_ptr<VertexL> nvt = addVertex(old_vt[order[i]]->point());
-      new_id[order[i]] = id;
-      nvt->setID(id++);
-      new_vt.push_back(nvt);
+      std::shared_ptr<VertexL>& vt = old_vt[order[i]];
+      vertices_.splice(vertices_.end(), vertices_, vt->iter());
+      new_id[vt->id()] = i;
     }
+    int id = 0;
+    for (auto& vt : vertices_) vt->setID(id++);
+    v_props_.permute(new_id, n_vt);
+    v_id_ = n_vt;
+    v_index_.rebuild(vertices_);
+  };
 
-    // reconnect the halfedge's vertices
-    for (auto& fc : faces_) {
-      for (auto& he : fc->halfedges()) {
-        he->setVertex(new_vt[new_id[he->vertex()->id()]]);
-      }
+  //
+  // reorder faces according to an array "order"
+  // (order[i]: list position of the face that comes i-th)
+  //
+  // Faces keep their halfedges (texcoords and normals included) and are
+  // renumbered 0 .. n-1; face properties follow.
+  //
+  void reorderFaces(std::vector<int>& order) {
+    int n_fc = faces_.size();
+    if ((int) order.size() != n_fc) return;
+
+    std::vector<std::shared_ptr<FaceL> > old_fc(faces_.begin(), faces_.end());
+    std::vector<int> new_id(f_id_, -1);
+    touchTopology();
+    for (int i = 0; i < n_fc; ++i) {
+      std::shared_ptr<FaceL>& fc = old_fc[order[i]];
+      faces_.splice(faces_.end(), faces_, fc->iter());
+      new_id[fc->id()] = i;
     }
+    int id = 0;
+    for (auto& fc : faces_) fc->setID(id++);
+    f_props_.permute(new_id, n_fc);
+    f_id_ = n_fc;
+    f_index_.rebuild(faces_);
+  };
 
-    // delete former vertices
-    auto vt_iter = vertices_.begin();
-    for (int i = 0; i < n_vt; ++i) {
-      auto nvt = vt_iter;
-      ++vt_iter;
-      deleteVertex(*nvt);
+  //
+  // renumber ids densely after elements were deleted
+  //
+  // Ids of every element kind become 0 .. n-1 in list order and the id
+  // counters restart from n.  Properties, smooth normals and moved marks
+  // are remapped; topology and connectivity are kept.
+  //
+  void compact() {
+    std::vector<int> new_vid = renumberIDs(vertices_, v_id_);
+    std::vector<int> new_fid = renumberIDs(faces_, f_id_);
+    std::vector<int> new_hid = renumberIDs(halfedges_, h_id_);
+    (void) renumberIDs(normals_, n_id_);
+    (void) renumberIDs(texcoords_, t_id_);
+    (void) renumberIDs(edges_, e_id_);
+    (void) renumberIDs(loops_, l_id_);
+    (void) renumberIDs(bloops_, bl_id_);
+
+    v_index_.shrink(vertices_);
+    f_index_.shrink(faces_);
+    h_index_.shrink(halfedges_);
+    n_index_.shrink(normals_);
+    t_index_.shrink(texcoords_);
+
+    v_props_.permute(new_vid, v_id_);
+    f_props_.permute(new_fid, f_id_);
+    h_props_.permute(new_hid, h_id_);
+
+    // caches indexed by vertex / face id
+    if (!vnormal_.empty()) {
+      std::vector<std::shared_ptr<NormalL> > vn(v_id_);
+      for (size_t i = 0; i < new_vid.size() && i < vnormal_.size(); ++i)
+        if (new_vid[i] >= 0) vn[new_vid[i]] = vnormal_[i];
+      vnormal_.swap(vn);
     }
+    std::vector<int> moved;
+    for (int id : v_moved_)
+      if (new_vid[id] >= 0) moved.push_back(new_vid[id]);
+    std::vector<char>().swap(v_moved_flag_);
+    v_moved_.clear();
+    for (int id : moved) markVertexMoved(id);
+    std::vector<char>().swap(v_dirty_);
+    std::vector<char>().swap(f_dirty_);
+    std::vector<int>().swap(vf_offset_);
+    std::vector<FaceL*>().swap(vf_faces_);
   };
 
   //
@@ -958,6 +1491,8 @@ class MeshL {
       ++fc_iter;
       deleteFace(*nfc);
     }
+    v_index_.rebuild(vertices_);
+    f_index_.rebuild(faces_);
   };
 
   unsigned int texID() const { return texID_; };
@@ -1009,6 +1544,7 @@ class MeshL {
       vt->setID(i);
       ++i;
     }
+    v_index_.rebuild(vertices_);
   };
 
   void resetHalfedgeID() {
@@ -1020,6 +1556,7 @@ class MeshL {
       }
     }
     assert(halfedges_size() == i);
+    h_index_.rebuild(halfedges_);
   };
 
   void resetFaceID() {
@@ -1028,6 +1565,7 @@ class MeshL {
       fc->setID(i);
       ++i;
     }
+    f_index_.rebuild(faces_);
   };
 
   void print() {
@@ -1051,65 +1589,439 @@ class MeshL {
 
 private:
 
+  // createConnectivity: halfedges in face order, the indices of their
+  // origin vertices (sv) and of their next halfedges (nx). Vertex ids are
+  // used when they are dense and unique (isIndexID), otherwise vertices
+  // are numbered in list order.
+  // returns the number of vertex indices
+  size_t collectHalfedgeVertexIndices(
+      std::vector<const std::shared_ptr<HalfedgeL>*>& hes,
+      std::vector<uint32_t>& sv, std::vector<uint32_t>& nx, bool& isIndexID) {
+    const size_t nv = vertices_.size();
+    bool dense = true;
+    {
+      std::vector<char> seen(nv, 0);
+      for (auto& vt : vertices_) {
+        const int id = vt->id();
+        if ((id < 0) || (id >= (int) nv) || seen[id]) {
+          dense = false;
+          break;
+        }
+        seen[id] = 1;
+      }
+    }
+    std::unordered_map<const VertexL*, uint32_t> vmap;
+    if (!dense) {
+      vmap.reserve(nv);
+      for (auto& vt : vertices_) vmap.emplace(vt.get(), (uint32_t) vmap.size());
+    }
+    auto index = [&](const std::shared_ptr<VertexL>& vt) -> uint32_t {
+      if (dense) return (uint32_t) vt->id();
+      auto it = vmap.find(vt.get());
+      if (it == vmap.end()) it = vmap.emplace(vt.get(), (uint32_t) vmap.size()).first;
+      return it->second;
+    };
+
+    hes.clear(); sv.clear(); nx.clear();
+    hes.reserve(halfedges_.size());
+    sv.reserve(halfedges_.size());
+    nx.reserve(halfedges_.size());
+    for (auto& fc : faces_) {
+      const size_t start = hes.size();
+      for (auto& he : fc->halfedges()) {
+        hes.push_back(&he);
+        sv.push_back(index(he->vertex()));
+      }
+      for (size_t i = start; i < hes.size(); ++i)
+        nx.push_back((uint32_t) ((i + 1 < hes.size()) ? i + 1 : start));
+    }
+    isIndexID = dense;
+    return dense ? nv : vmap.size();
+  };
+
+  // createConnectivity: print warnings in face order. Edge numbers are
+  // the ids edges get in createConnectivity(false).
+  void reportConnectivityWarnings(
+      const std::vector<const std::shared_ptr<HalfedgeL>*>& hes,
+      const std::vector<meshl_detail::HalfedgeKey>& keys,
+      std::vector<std::vector<meshl_detail::ConnectivityWarning>>& warnings,
+      int e_base) {
+    std::vector<meshl_detail::ConnectivityWarning> all;
+    for (auto& w : warnings) all.insert(all.end(), w.begin(), w.end());
+    if (all.empty()) return;
+    std::stable_sort(all.begin(), all.end(),
+                     [](const meshl_detail::ConnectivityWarning& a,
+                        const meshl_detail::ConnectivityWarning& b) {
+                       if (a.seq != b.seq) return a.seq < b.seq;
+                       return !a.invalid && b.invalid;
+                     });
+    std::vector<uint32_t> firsts;
+    for (size_t i = 0; i < keys.size(); ++i)
+      if ((i == 0) || (keys[i].key != keys[i - 1].key)) firsts.push_back(keys[i].seq);
+    std::sort(firsts.begin(), firsts.end());
+
+    for (auto& w : all) {
+      const int ed_id = e_base + (int) (std::lower_bound(firsts.begin(), firsts.end(), w.first)
+                                        - firsts.begin());
+      const std::shared_ptr<HalfedgeL>& he = *hes[w.seq];
+      if (!w.invalid) {
+        std::cerr << "Warning: More than three halfedges. Edge No."
+                  << ed_id << std::endl;
+        std::cerr << "fc " << he->face()->id() << " he " << he->id()
+                  << std::endl;
+      } else {
+        std::cerr << "Warning: invalid halfedge pair. Edge No." << ed_id
+                  << std::endl;
+      }
+    }
+  };
+
+  // buildFromArrays: point(i) -> Eigen::Vector3d, index(k) -> k-th face index
+  template <class PointAt, class IndexAt>
+  bool buildFromArraysT(int n_vertices, PointAt point, int n_faces,
+                        const int* offsets, IndexAt index,
+                        bool isCreateConnectivity) {
+    if ((n_vertices < 0) || (n_faces < 0)) return false;
+    const size_t n_indices = offsets ? (size_t) offsets[n_faces] : (size_t) 3 * n_faces;
+    if (offsets) {
+      if (offsets[0] != 0) return false;
+      for (int f = 0; f < n_faces; ++f)
+        if ((int64_t) offsets[f + 1] - offsets[f] < 3) return false;
+    }
+    for (size_t k = 0; k < n_indices; ++k) {
+      const int i = index(k);
+      if ((i < 0) || (i >= n_vertices)) return false;
+    }
+
+    const bool isAppend = !(faces_.empty()) || !(vertices_.empty());
+    reserve(n_vertices, n_faces, (int) n_indices);
+
+    std::vector<std::shared_ptr<VertexL>> vts(n_vertices);
+    for (int i = 0; i < n_vertices; ++i) {
+      Eigen::Vector3d p = point(i);
+      vts[i] = addVertex(p);
+    }
+
+    std::vector<const std::shared_ptr<HalfedgeL>*> hes;
+    std::vector<uint32_t> sv, nx;
+    if (isCreateConnectivity && !isAppend) {
+      hes.reserve(n_indices);
+      sv.resize(n_indices);
+      nx.resize(n_indices);
+    }
+    for (int f = 0; f < n_faces; ++f) {
+      const size_t b = offsets ? (size_t) offsets[f] : (size_t) 3 * f;
+      const size_t e = offsets ? (size_t) offsets[f + 1] : b + 3;
+      std::shared_ptr<FaceL> fc = addFace();
+      for (size_t k = b; k < e; ++k) {
+        const int i = index(k);
+        std::shared_ptr<HalfedgeL> he = addHalfedge(fc, vts[i]);
+        if (hes.capacity()) {
+          hes.push_back(&(*(he->meshIter())));
+          sv[k] = (uint32_t) i;
+          nx[k] = (uint32_t) ((k + 1 < e) ? k + 1 : b);
+        }
+      }
+    }
+    if (isCreateConnectivity) {
+      if (isAppend) {
+        createConnectivity(true);
+      } else {
+        if (isConnectivity()) deleteConnectivity();
+        if (!(edges_.empty())) deleteAllEdges();
+        pairHalfedges(hes, sv, nx, (size_t) n_vertices, false, true);
+      }
+    }
+    return true;
+  };
+
+  // 1 + the largest vertex id
+  int vertexIDRange() const {
+    int n = 0;
+    for (auto& vt : vertices_)
+      if (vt->id() >= n) n = vt->id() + 1;
+    return n;
+  };
+
+  // vertex id -> incident faces, in face order (rebuilt per topology)
+  void buildVertexFaces() {
+    if (!vf_offset_.empty() && (vf_version_ == topology_version_)) return;
+    const int n = vertexIDRange();
+    vf_offset_.assign(n + 1, 0);
+    for (auto& fc : faces_)
+      for (auto& he : fc->halfedges()) vf_offset_[he->vertex()->id() + 1]++;
+    for (int i = 0; i < n; ++i) vf_offset_[i + 1] += vf_offset_[i];
+    vf_faces_.resize(vf_offset_[n]);
+    std::vector<int> pos(vf_offset_.begin(), vf_offset_.end() - 1);
+    for (auto& fc : faces_)
+      for (auto& he : fc->halfedges()) vf_faces_[pos[he->vertex()->id()]++] = fc.get();
+    vf_version_ = topology_version_;
+  };
+
+  // same sums as calcSmoothVertexNormal, for one vertex
+  void updateSmoothVertexNormal(int id) {
+    if ((id < 0) || (id >= (int) vnormal_.size()) || !vnormal_[id]) return;
+    if (id + 1 >= (int) vf_offset_.size()) return;
+    Eigen::Vector3d nmvec = smoothVertexNormal(id);
+    vnormal_[id]->setPoint(nmvec);
+  };
+
+  Eigen::Vector3d smoothVertexNormal(int id) const {
+    int n_vf = 0;
+    double area = 0.0;
+    Eigen::Vector3d nmvec = Eigen::Vector3d::Zero();
+    for (int k = vf_offset_[id]; k < vf_offset_[id + 1]; ++k) {
+      FaceL* fc = vf_faces_[k];
+      double a = fc->area();
+      n_vf++;
+      area += a;
+      Eigen::Vector3d nrm = fc->normal();
+      nrm *= a;
+      nmvec += nrm;
+    }
+    double f = (double)n_vf;
+    nmvec /= (f * area);
+    nmvec.normalize();
+    return nmvec;
+  };
+
+  // calcSmoothVertexNormal for large meshes: per-vertex sums over the
+  // vertex-face table (same order and values as the serial pass)
+  void calcSmoothVertexNormalParallel() {
+    buildVertexFaces();
+    const int n = (int) vf_offset_.size() - 1;
+    std::vector<char> present(n, 0);
+    for (auto& vt : vertices_) present[vt->id()] = 1;
+
+    std::vector<Eigen::Vector3d> nmvec(n);
+    par_util::parallelFor(0, (size_t) n, [&](size_t i) {
+      if (present[i]) nmvec[i] = smoothVertexNormal((int) i);
+    }, kParallelGrain);
+
+    vnormal_.assign(n, nullptr);
+    for (int i = 0; i < n; ++i) {
+      if (!present[i]) continue;
+      vnormal_[i] = addNormal(nmvec[i]);
+    }
+
+    const std::vector<FaceL*>& fa = faceArray();
+    par_util::parallelFor(0, fa.size(), [&](size_t i) {
+      for (auto& he : fa[i]->halfedges()) he->setNormal(vnormal_[he->vertex()->id()]);
+    }, kParallelGrain);
+
+    isSmoothNormal_ = true;
+    vn_version_ = topology_version_;
+    clearMovedVertices();
+  };
+
+  //
+  // parallel whole-mesh passes (thread count: par_util::setNumThreads)
+  //
+  // lists with fewer than 2 * kParallelGrain elements (or a single
+  // thread) use the serial loops
+  static constexpr size_t kParallelGrain = 1 << 14;
+
+  static bool isParallelPass(size_t n) {
+    return (par_util::numChunks(n, kParallelGrain) > 1);
+  };
+
+  // element pointers in list order (rebuilt when the lists change)
+  const std::vector<VertexL*>& vertexArray() {
+    if (v_array_version_ != list_version_ || v_array_.size() != vertices_.size()) {
+      v_array_.clear();
+      v_array_.reserve(vertices_.size());
+      for (auto& vt : vertices_) v_array_.push_back(vt.get());
+      v_array_version_ = list_version_;
+    }
+    return v_array_;
+  };
+
+  const std::vector<FaceL*>& faceArray() {
+    if (f_array_version_ != list_version_ || f_array_.size() != faces_.size()) {
+      f_array_.clear();
+      f_array_.reserve(faces_.size());
+      for (auto& fc : faces_) f_array_.push_back(fc.get());
+      f_array_version_ = list_version_;
+    }
+    return f_array_;
+  };
+
+  const std::vector<TexcoordL*>& texcoordArray() {
+    if (t_array_version_ != list_version_ || t_array_.size() != texcoords_.size()) {
+      t_array_.clear();
+      t_array_.reserve(texcoords_.size());
+      for (auto& tc : texcoords_) t_array_.push_back(tc.get());
+      t_array_version_ = list_version_;
+    }
+    return t_array_;
+  };
+
+  // per-chunk min/max of point() (x, y, z)
+  template <class T>
+  static void parallelBB(const std::vector<T*>& a,
+                         Eigen::Vector3d& bbmin, Eigen::Vector3d& bbmax) {
+    if (a.empty()) return;
+    const int nchunks = par_util::numChunks(a.size(), kParallelGrain);
+    std::vector<Eigen::Vector3d> cmin(nchunks), cmax(nchunks);
+    par_util::forChunks(a.size(), nchunks, [&](size_t b, size_t e, int c) {
+      Eigen::Vector3d lo = a[b]->point(), hi = lo;
+      for (size_t i = b + 1; i < e; ++i) {
+        const Eigen::Vector3d& p = a[i]->point();
+        lo = lo.cwiseMin(p);
+        hi = hi.cwiseMax(p);
+      }
+      cmin[c] = lo;
+      cmax[c] = hi;
+    });
+    bbmin = cmin[0];
+    bbmax = cmax[0];
+    for (int c = 1; c < nchunks; ++c) {
+      bbmin = bbmin.cwiseMin(cmin[c]);
+      bbmax = bbmax.cwiseMax(cmax[c]);
+    }
+  };
+
+  void clearMovedVertices() {
+    for (int id : v_moved_) v_moved_flag_[id] = 0;
+    v_moved_.clear();
+    vn_all_moved_ = false;
+  };
+
+  // ids 0 .. n-1 in list order; returns the new id of each old id
+  template <class T>
+  std::vector<int> renumberIDs(std::list<std::shared_ptr<T> >& l, int& counter) {
+    std::vector<int> new_id(counter, -1);
+    int id = 0;
+    for (auto& e : l) {
+      const int old = e->id();
+      if ((old >= 0) && (old < counter) && (new_id[old] < 0)) new_id[old] = id;
+      e->setID(id++);
+    }
+    counter = id;
+    return new_id;
+  };
+
+  // element allocation
+  // hint: slab reservation, consumed by the first allocation
+  template <class T>
+  std::shared_ptr<T> newElement(int id, size_t& hint) {
+    if (!arena_) return std::make_shared<T>(id);
+    std::shared_ptr<T> e = std::allocate_shared<T>(
+        meshl_detail::ArenaAllocator<T>(arena_.get(), hint), id);
+    hint = 0;
+    return e;
+  };
+
+  meshl_detail::ArenaRef arena_;
+
+  MeshEditLogL* edit_log_ = nullptr;
+
+  // properties
+  PropertyRegistryL v_props_;
+  PropertyRegistryL f_props_;
+  PropertyRegistryL h_props_;
+  size_t v_hint_, n_hint_, t_hint_, h_hint_, f_hint_, e_hint_;
+
   // vertices
 
   std::shared_ptr<VertexL> addVertex() {
     int32_t id = v_id_++;
-    std::shared_ptr<VertexL> vt = std::make_shared<VertexL>(id);
+    std::shared_ptr<VertexL> vt = newElement<VertexL>(id, v_hint_);
     vt->setIter(vertices_.insert(vertices_.end(), vt));
+    v_index_.insert(vt);
+    ++list_version_;
+    if (edit_log_) edit_log_->added(vt);
     return vt;
   };
   
   int v_id_;
   std::list<std::shared_ptr<VertexL> > vertices_;
+  meshl_detail::IdIndex<VertexL> v_index_;
 
   // normals (for smooth shading)
 
   std::shared_ptr<NormalL> addNormal() {
     int32_t id = n_id_++;
-    std::shared_ptr<NormalL> nm = std::make_shared<NormalL>(id);
+    std::shared_ptr<NormalL> nm = newElement<NormalL>(id, n_hint_);
     nm->setIter(normals_.insert(normals_.end(), nm));
+    n_index_.insert(nm);
     return nm;
   };
 
   int n_id_;
   std::list<std::shared_ptr<NormalL> > normals_;
+  meshl_detail::IdIndex<NormalL> n_index_;
+
+  // smooth vertex normals (calcSmoothVertexNormal)
+  // isSmoothNormal_: normals_ were made by calcSmoothVertexNormal
+  // vnormal_: normal of each vertex id, vn_version_: its topology version
+  bool isSmoothNormal_;
+  std::vector<std::shared_ptr<NormalL> > vnormal_;
+  uint64_t vn_version_;
+  // moved vertices and dirty flags (indexed by id)
+  std::vector<int> v_moved_;
+  std::vector<char> v_moved_flag_;
+  bool vn_all_moved_;
+  std::vector<char> v_dirty_;
+  std::vector<char> f_dirty_;
+  std::vector<FaceL*> dirty_faces_;
+  std::vector<int> dirty_vertices_;
+  // faces around each vertex id (CSR, one entry per halfedge)
+  std::vector<int> vf_offset_;
+  std::vector<FaceL*> vf_faces_;
+  uint64_t vf_version_;
+
+  // element arrays for the parallel passes
+  // list_version_: bumped when vertices, faces or texcoords are added/deleted
+  uint64_t list_version_;
+  std::vector<VertexL*> v_array_;
+  std::vector<FaceL*> f_array_;
+  std::vector<TexcoordL*> t_array_;
+  uint64_t v_array_version_, f_array_version_, t_array_version_;
 
   // texcoords
 
   std::shared_ptr<TexcoordL> addTexcoord() {
     int32_t id = t_id_++;
-    std::shared_ptr<TexcoordL> tc = std::make_shared<TexcoordL>(id);
+    std::shared_ptr<TexcoordL> tc = newElement<TexcoordL>(id, t_hint_);
     tc->setIter(texcoords_.insert(texcoords_.end(), tc));
+    t_index_.insert(tc);
+    ++list_version_;
     return tc;
   };
 
   int t_id_;
   std::list<std::shared_ptr<TexcoordL> > texcoords_;
+  meshl_detail::IdIndex<TexcoordL> t_index_;
 
   // halfedges
 
   std::shared_ptr<HalfedgeL> addHalfedge() {
     int32_t id = h_id_++;
-    std::shared_ptr<HalfedgeL> he = std::make_shared<HalfedgeL>(id);
+    std::shared_ptr<HalfedgeL> he = newElement<HalfedgeL>(id, h_hint_);
     he->setMeshIter(halfedges_.insert(halfedges_.end(), he));
     // he->setMeshEnd(halfedges_.end());
+    h_index_.insert(he);
+    touchTopology();
+    if (edit_log_) edit_log_->added(he);
     return he;
   };
 
   int h_id_;
   std::list<std::shared_ptr<HalfedgeL> > halfedges_;
+  meshl_detail::IdIndex<HalfedgeL> h_index_;
 
   // faces
 
   int f_id_;
   std::list<std::shared_ptr<FaceL> > faces_;
+  meshl_detail::IdIndex<FaceL> f_index_;
 
   // edges (define if needed)
 
   std::shared_ptr<EdgeL> addEdge() {
     int32_t id = e_id_++;
-    std::shared_ptr<EdgeL> ed = std::make_shared<EdgeL>(id);
+    std::shared_ptr<EdgeL> ed = newElement<EdgeL>(id, e_hint_);
     ed->setIter(edges_.insert(edges_.end(), ed));
     return ed;
   };
@@ -1126,6 +2038,9 @@ private:
   std::list<std::shared_ptr<BLoopL> > bloops_;
 
   bool isConnectivity_;
+  // topology_version_ when the mates were built (see createConnectivity)
+  uint64_t topology_version_;
+  uint64_t connectivity_version_;
 
   bool isNormalized_;
   Eigen::Vector3d center_;
@@ -0,0 +1,638 @@
+////////////////////////////////////////////////////////////////////
+//
+// Quantized, entropy-coded mesh container (.mlz) for MeshL.
+//
+// Positions, texcoords, normals and colors are quantized on a uniform
+// grid over their bounding box with a configurable number of bits per
+// component.  Vertices (and texcoords / normals) are renumbered in the
+// order the faces first use them, so that
+//
+//   - each face corner is coded as "new", a hit in a 32-entry
+//     move-to-front cache of recent indices, or an explicit backward
+//     distance, with adaptive models (one per corner position), and
+//   - the quantized values are delta-coded against the previous
+//     element in that order,
+//
+// through an adaptive binary range coder (RangeCoder.hxx).
+// Connectivity and attributes are separate streams, decoded
+// concurrently.  The largest error introduced by quantization is stored in the header and
+// reported by maxPositionError() etc. after writing or reading.
+//
+// Normals, texcoords, colors and boundary loops are written according
+// to isSaveNormal / isSaveTexcoord / isSaveColor / isSaveBLoop.
+// Normalized meshes are stored in their original scale.  The decoded
+// mesh keeps the faces in order; vertex, texcoord and normal lists are
+// in first-use order (unused ones at the end).
+//
+//   MeshPackLIO io(mesh);
+//   io.setPositionBits(16);
+//   io.outputToFile("bunny.mlz");
+//   io.inputFromFile("bunny.mlz");
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHPACKLIO_HXX
+#define _MESHPACKLIO_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LIO.hxx"
+#include "ObjParserL.hxx"
+#include "ParallelFor.hxx"
+#include "RangeCoder.hxx"
+#include "myEigen.hxx"
+
+struct MeshPackHeader {
+  char magic[8];            // "MESHLZ\0\0"
+  uint32_t version;
+  uint32_t byte_order;      // kByteOrder as written
+  uint32_t flags;
+  uint32_t n_vertices;
+  uint32_t n_texcoords;
+  uint32_t n_normals;
+  uint32_t n_faces;
+  uint32_t n_halfedges;
+  uint32_t n_bloops;
+  uint32_t reserved;
+  // quantization of positions, texcoords, normals, colors
+  uint32_t bits[4];
+  double min[4][3];
+  double cell[4];
+  double max_error[4];
+  uint64_t payload_bytes[2];  // connectivity, attributes
+
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kByteOrder = 0x01020304;
+  enum Flags : uint32_t { kTexcoords = 1, kNormals = 2, kColors = 4, kTriangles = 8 };
+  enum Attribute { POSITION = 0, TEXCOORD, NORMAL, COLOR };
+};
+
+class MeshPackLIO : public LIO {
+
+ public:
+
+  MeshPackLIO() : LIO() {};
+  MeshPackLIO(MeshL& mesh) : LIO(mesh) {};
+  ~MeshPackLIO() {};
+
+  // bits per component (1 - 30)
+  void setPositionBits(int b) { bits_[MeshPackHeader::POSITION] = clampBits(b); };
+  void setTexcoordBits(int b) { bits_[MeshPackHeader::TEXCOORD] = clampBits(b); };
+  void setNormalBits(int b) { bits_[MeshPackHeader::NORMAL] = clampBits(b); };
+  void setColorBits(int b) { bits_[MeshPackHeader::COLOR] = clampBits(b); };
+  int positionBits() const { return bits_[MeshPackHeader::POSITION]; };
+  int texcoordBits() const { return bits_[MeshPackHeader::TEXCOORD]; };
+  int normalBits() const { return bits_[MeshPackHeader::NORMAL]; };
+  int colorBits() const { return bits_[MeshPackHeader::COLOR]; };
+
+  // largest distance between an original and a quantized value
+  // (of the last file written or read)
+  double maxPositionError() const { return max_error_[MeshPackHeader::POSITION]; };
+  double maxTexcoordError() const { return max_error_[MeshPackHeader::TEXCOORD]; };
+  double maxNormalError() const { return max_error_[MeshPackHeader::NORMAL]; };
+  double maxColorError() const { return max_error_[MeshPackHeader::COLOR]; };
+
+  bool inputFromFile(const char* const filename) {
+    std::string buf;
+    if (!ObjParserL::readFile(filename, buf)) {
+      std::cerr << "Cannot open " << filename << std::endl;
+      return false;
+    }
+    MeshPackHeader h;
+    memset(&h, 0, sizeof(h));
+    if (buf.size() >= sizeof(h)) memcpy(&h, buf.data(), sizeof(h));
+    if ((buf.size() < sizeof(h)) || memcmp(h.magic, kMagic, 8) ||
+        (h.version != MeshPackHeader::kVersion) || (h.byte_order != MeshPackHeader::kByteOrder) ||
+        (h.payload_bytes[0] > buf.size() - sizeof(h)) ||
+        (h.payload_bytes[1] > buf.size() - sizeof(h) - h.payload_bytes[0])) {
+      std::cerr << "Not a mesh pack (or other version / byte order): " << filename << std::endl;
+      return false;
+    }
+    if (!checkHeader(h)) {
+      std::cerr << "Broken mesh pack: " << filename << std::endl;
+      return false;
+    }
+    for (int a = 0; a < 4; ++a) max_error_[a] = h.max_error[a];
+    const uint8_t* payload = (const uint8_t*) buf.data() + sizeof(h);
+
+    const size_t nv = h.n_vertices, nt = h.n_texcoords, nn = h.n_normals;
+    const size_t nf = h.n_faces, nh = h.n_halfedges;
+    const bool has_t = (h.flags & MeshPackHeader::kTexcoords) != 0;
+    const bool has_n = (h.flags & MeshPackHeader::kNormals) != 0;
+
+    std::vector<uint32_t> face_size(nf, 3);
+    std::vector<int64_t> he_vertex(nh), he_texcoord(has_t ? nh : 0), he_normal(has_n ? nh : 0);
+    std::vector<Eigen::Vector3d> points, texcoords, normals, colors;
+    std::vector<uint8_t> has_color;
+    std::vector<std::vector<std::pair<uint32_t, bool> > > bloops(h.n_bloops);
+    bool ok[2] = {false, false};
+    par_util::forChunks(2, std::min(2, par_util::numThreads()), [&](size_t b, size_t e, int) {
+      for (size_t part = b; part < e; ++part) {
+        const uint8_t* p = payload + ((part == 0) ? 0 : h.payload_bytes[0]);
+        rc_util::RangeDecoder rc(p, p + h.payload_bytes[part]);
+        if (part == 0) ok[0] = decodeConnectivity(rc, h, face_size, he_vertex, he_texcoord, he_normal);
+        else ok[1] = decodeAttributes(rc, h, points, has_color, colors, texcoords, normals, bloops);
+        ok[part] = ok[part] && !rc.overrun();
+      }
+    });
+    if (!ok[0] || !ok[1]) {
+      std::cerr << "Broken mesh pack: " << filename << std::endl;
+      return false;
+    }
+
+    //
+    // build the mesh
+    //
+    mesh().reserve((int) nv, (int) nf, (int) nh, (int) nt, (int) nn);
+    std::vector<std::shared_ptr<VertexL> > vts(nv);
+    size_t ic = 0;
+    for (size_t i = 0; i < nv; ++i) {
+      vts[i] = mesh().addVertex(points[i]);
+      if (!has_color.empty() && has_color[i]) vts[i]->setColor(colors[ic++]);
+    }
+    std::vector<std::shared_ptr<TexcoordL> > tcs(nt);
+    for (size_t i = 0; i < nt; ++i) tcs[i] = mesh().addTexcoord(texcoords[i]);
+    std::vector<std::shared_ptr<NormalL> > nms(nn);
+    for (size_t i = 0; i < nn; ++i) nms[i] = mesh().addNormal(normals[i]);
+
+    std::vector<FaceL*> faces(nf);
+    size_t j = 0;
+    for (size_t f = 0; f < nf; ++f) {
+      std::shared_ptr<FaceL> fc = mesh().addFace();
+      for (uint32_t k = 0; k < face_size[f]; ++k, ++j) {
+        mesh().addHalfedge(fc, vts[he_vertex[j]],
+                           (has_n && (he_normal[j] >= 0)) ? nms[he_normal[j]] : nullptr,
+                           (has_t && (he_texcoord[j] >= 0)) ? tcs[he_texcoord[j]] : nullptr);
+      }
+      faces[f] = fc.get();
+    }
+    par_util::parallelFor(0, faces.size(), [&](size_t i) {
+      if (faces[i]->size() >= 3) faces[i]->calcNormal();
+    });
+
+    for (auto& b : bloops) {
+      std::shared_ptr<BLoopL> bl = mesh().addBLoop();
+      for (auto& v : b) {
+        bl->addIsCorner(v.second);
+        bl->addVertex(vts[v.first]);
+      }
+    }
+
+    mesh().printInfo();
+    printError();
+
+    return true;
+  };
+
+  bool outputToFile(const char* const filename) {
+    mesh().printInfo();
+
+    MeshPackHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kMagic, 8);
+    h.version = MeshPackHeader::kVersion;
+    h.byte_order = MeshPackHeader::kByteOrder;
+    for (int a = 0; a < 4; ++a) {
+      h.bits[a] = (uint32_t) bits_[a];
+      h.cell[a] = 1.0;
+    }
+
+    //
+    // first-use order of vertices, texcoords and normals
+    //
+    Order<VertexL> vorder;
+    Order<TexcoordL> torder;
+    Order<NormalL> norder;
+    for (auto& vt : mesh().vertices()) vorder.add(vt.get());
+    if (isSaveTexcoord())
+      for (auto& tc : mesh().texcoords()) torder.add(tc.get());
+    if (isSaveNormal())
+      for (auto& nm : mesh().normals()) norder.add(nm.get());
+
+    std::vector<uint32_t> face_size;
+    std::vector<int64_t> he_vertex, he_texcoord, he_normal;
+    face_size.reserve(mesh().faces_size());
+    bool triangles = true;
+    for (auto& fc : mesh().faces()) {
+      face_size.push_back((uint32_t) fc->halfedges().size());
+      triangles = triangles && (face_size.back() == 3);
+      for (auto& he : fc->halfedges()) {
+        const int64_t v = vorder.use(he->vertexRaw());
+        if (v < 0) {
+          std::cerr << "Halfedge vertex not in the mesh" << std::endl;
+          return false;
+        }
+        he_vertex.push_back(v);
+        he_texcoord.push_back(torder.use(he->texcoordRaw()));
+        he_normal.push_back(norder.use(he->normalRaw()));
+      }
+    }
+    vorder.finish();
+    torder.finish();
+    norder.finish();
+    const bool has_t = !torder.empty();
+    const bool has_n = !norder.empty();
+
+    h.n_vertices = (uint32_t) vorder.size();
+    h.n_texcoords = (uint32_t) torder.size();
+    h.n_normals = (uint32_t) norder.size();
+    h.n_faces = (uint32_t) face_size.size();
+    h.n_halfedges = (uint32_t) he_vertex.size();
+    if (has_t) h.flags |= MeshPackHeader::kTexcoords;
+    if (has_n) h.flags |= MeshPackHeader::kNormals;
+    if (triangles) h.flags |= MeshPackHeader::kTriangles;
+
+    //
+    // values in the new order
+    //
+    std::vector<Eigen::Vector3d> points, colors, texcoords, normals;
+    std::vector<uint8_t> has_color;
+    const bool norm = mesh().isNormalized();
+    const double len = mesh().maxLength();
+    const Eigen::Vector3d center = mesh().center();
+    for (VertexL* vt : vorder.elements()) {
+      points.push_back(norm ? Eigen::Vector3d(vt->point() * len + center) : vt->point());
+      has_color.push_back((isSaveColor() && vt->hasColor()) ? 1 : 0);
+      if (has_color.back()) colors.push_back(vt->color());
+    }
+    if (!colors.empty()) h.flags |= MeshPackHeader::kColors;
+    for (TexcoordL* tc : torder.elements()) texcoords.push_back(tc->point());
+    for (NormalL* nm : norder.elements()) normals.push_back(nm->point());
+
+    //
+    // payload
+    //
+    std::vector<uint8_t> payload[2];
+    {
+      rc_util::RangeEncoder rc(payload[0]);
+      IndexCoder vcoder(vorder.size()), tcoder(torder.size()), ncoder(norder.size());
+      rc_util::IntModel size_model;
+      size_t j = 0;
+      for (uint32_t n : face_size) {
+        if (!triangles) size_model.encode(rc, n);
+        for (uint32_t k = 0; k < n; ++k, ++j) {
+          const int ctx = std::min(k, 2u);
+          vcoder.encode(rc, he_vertex[j], ctx);
+          if (has_t) tcoder.encode(rc, he_texcoord[j], ctx);
+          if (has_n) ncoder.encode(rc, he_normal[j], ctx);
+        }
+      }
+      rc.flush();
+    }
+    {
+      rc_util::RangeEncoder rc(payload[1]);
+      encodeValues(rc, h, MeshPackHeader::POSITION, points);
+      if (h.flags & MeshPackHeader::kColors) {
+        uint16_t prob = rc_util::kProbInit;
+        for (auto c : has_color) rc.encodeBit(prob, c);
+        encodeValues(rc, h, MeshPackHeader::COLOR, colors);
+      }
+      encodeValues(rc, h, MeshPackHeader::TEXCOORD, texcoords);
+      encodeValues(rc, h, MeshPackHeader::NORMAL, normals);
+
+      if (isSaveBLoop()) {
+        rc_util::IntModel count_model, id_model;
+        uint16_t corner_prob = rc_util::kProbInit;
+        for (auto& bl : mesh().bloops()) {
+          std::vector<std::pair<int64_t, bool> > vs;
+          for (unsigned int i = 0; i < bl->vertices().size(); ++i) {
+            const int64_t id = vorder.find(bl->vertex(i).get());
+            if (id >= 0) vs.push_back(std::make_pair(id, bl->isCorner(i)));
+          }
+          count_model.encode(rc, (uint32_t) vs.size());
+          int64_t prev = 0;
+          for (auto& v : vs) {
+            id_model.encodeSigned(rc, (int32_t) (v.first - prev));
+            rc.encodeBit(corner_prob, v.second ? 1 : 0);
+            prev = v.first;
+          }
+          ++h.n_bloops;
+        }
+      }
+      rc.flush();
+    }
+    h.payload_bytes[0] = payload[0].size();
+    h.payload_bytes[1] = payload[1].size();
+    for (int a = 0; a < 4; ++a) max_error_[a] = h.max_error[a];
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == nullptr) {
+      std::cerr << "Cannot open " << filename << std::endl;
+      return false;
+    }
+    bool ok = (fwrite(&h, sizeof(h), 1, fp) == 1);
+    for (auto& pl : payload) ok = ok && (fwrite(pl.data(), 1, pl.size(), fp) == pl.size());
+    ok = (fclose(fp) == 0) && ok;
+
+    printError();
+
+    return ok;
+  };
+
+ private:
+
+  static constexpr char kMagic[8] = {'M', 'E', 'S', 'H', 'L', 'Z', 0, 0};
+
+  int bits_[4] = {16, 12, 10, 8};
+  double max_error_[4] = {0.0, 0.0, 0.0, 0.0};
+
+  static int clampBits(int b) { return std::max(1, std::min(30, b)); };
+
+  // An adaptive bit costs at least -log2(2017 / 2048) ~ 0.022 bits, so
+  // a stream of n bytes (plus the flushed tail the decoder may read
+  // past) holds at most about 364 n binary decisions.
+  static constexpr uint64_t kMaxDecisionsPerByte = 384;
+  static constexpr uint64_t kTailBytes = 8;
+
+  static uint64_t maxDecisions(uint64_t bytes) { return kMaxDecisionsPerByte * (bytes + kTailBytes); };
+
+  // counts consistent with each other and with the payload sizes,
+  // checked before anything is allocated from them
+  static bool checkHeader(const MeshPackHeader& h) {
+    for (int a = 0; a < 4; ++a)
+      if ((h.bits[a] < 1) || (h.bits[a] > 30)) return false;
+    const uint64_t nv = h.n_vertices, nt = h.n_texcoords, nn = h.n_normals;
+    const uint64_t nf = h.n_faces, nh = h.n_halfedges;
+    if (h.n_bloops > nv) return false;
+    // each corner costs at least one decision, each face size (unless
+    // all faces are triangles) a bucket symbol of 6 decisions
+    if (h.flags & MeshPackHeader::kTriangles) {
+      if (nh != 3 * nf) return false;
+      if (nh > maxDecisions(h.payload_bytes[0])) return false;
+    } else {
+      if (nh + 6 * nf > maxDecisions(h.payload_bytes[0])) return false;
+    }
+    // each value costs at least three bucket symbols of 6 decisions;
+    // each boundary loop at least one bucket symbol
+    if (18 * (nv + nt + nn) + 6 * h.n_bloops > maxDecisions(h.payload_bytes[1])) return false;
+    return true;
+  };
+
+  void printError() const {
+    std::cout << "quantization error: position " << maxPositionError();
+    if (maxTexcoordError() > 0.0) std::cout << " texcoord " << maxTexcoordError();
+    if (maxNormalError() > 0.0) std::cout << " normal " << maxNormalError();
+    if (maxColorError() > 0.0) std::cout << " color " << maxColorError();
+    std::cout << std::endl;
+  };
+
+  // elements of a list renumbered in first-use order
+  template <class T>
+  class Order {
+   public:
+    void add(T* e) {
+      index_[e] = (int64_t) all_.size();
+      all_.push_back(e);
+    };
+    // new id of e (-1: null or not in the list)
+    int64_t use(T* e) {
+      if (e == nullptr) return -1;
+      auto it = index_.find(e);
+      if (it == index_.end()) return -1;
+      const int64_t i = it->second;
+      if (id_.empty()) id_.assign(all_.size(), -1);
+      if (id_[i] < 0) {
+        id_[i] = (int64_t) order_.size();
+        order_.push_back(e);
+      }
+      return id_[i];
+    };
+    // unused elements at the end
+    void finish() {
+      if (id_.empty()) id_.assign(all_.size(), -1);
+      for (size_t i = 0; i < all_.size(); ++i)
+        if (id_[i] < 0) {
+          id_[i] = (int64_t) order_.size();
+          order_.push_back(all_[i]);
+        }
+    };
+    int64_t find(T* e) const {
+      auto it = index_.find(e);
+      return (it == index_.end()) ? -1 : id_[it->second];
+    };
+    const std::vector<T*>& elements() const { return order_; };
+    size_t size() const { return order_.size(); };
+    bool empty() const { return order_.empty(); };
+
+   private:
+    std::unordered_map<const T*, int64_t> index_;
+    std::vector<T*> all_;
+    std::vector<int64_t> id_;
+    std::vector<T*> order_;
+  };
+
+  // corner indices: new / move-to-front cache hit / distance / none,
+  // as a short decision tree: new?  near (cache 0-3)?  otherwise one of
+  // cache 4-31, distance, none
+  class IndexCoder {
+   public:
+    explicit IndexCoder(size_t count) : count_(count) {
+      for (auto& p : is_new_) p = rc_util::kProbInit;
+      for (auto& p : is_near_) p = rc_util::kProbInit;
+    };
+
+    void encode(rc_util::RangeEncoder& rc, int64_t id, int ctx) {
+      if ((id >= 0) && ((size_t) id == next_)) {
+        rc.encodeBit(is_new_[ctx], 1);
+        ++next_;
+        push((uint32_t) id, size_);
+        return;
+      }
+      rc.encodeBit(is_new_[ctx], 0);
+      int k = size_;
+      if (id >= 0)
+        for (k = 0; k < size_; ++k)
+          if (cache_[k] == (uint32_t) id) break;
+      const bool near = (k < size_) && (k < kNear);
+      rc.encodeBit(is_near_[ctx], near ? 1 : 0);
+      if (near) {
+        near_[ctx].encode(rc, (uint32_t) k);
+      } else if (id < 0) {
+        far_[ctx].encode(rc, kNone);
+        return;
+      } else if (k < size_) {
+        far_[ctx].encode(rc, (uint32_t) (k - kNear));
+      } else {
+        far_[ctx].encode(rc, kEscape);
+        distance_.encode(rc, (uint32_t) (next_ - 1 - (size_t) id));
+      }
+      push((uint32_t) id, k);
+    };
+
+    // -1: none
+    int64_t decode(rc_util::RangeDecoder& rc, int ctx) {
+      uint32_t id;
+      int k = size_;
+      if (rc.decodeBit(is_new_[ctx])) {
+        if (next_ >= count_) return fail();
+        id = (uint32_t) next_++;
+      } else if (rc.decodeBit(is_near_[ctx])) {
+        k = (int) near_[ctx].decode(rc);
+        if (k >= size_) return fail();
+        id = cache_[k];
+      } else {
+        const uint32_t s = far_[ctx].decode(rc);
+        if (s == kNone) return -1;
+        if (s == kEscape) {
+          const uint32_t d = distance_.decode(rc);
+          if (d >= next_) return fail();
+          id = (uint32_t) (next_ - 1 - d);
+        } else {
+          k = kNear + (int) s;
+          if ((s > kEscape) || (k >= size_)) return fail();
+          id = cache_[k];
+        }
+      }
+      push(id, k);
+      return id;
+    };
+
+    bool ok() const { return ok_; };
+
+   private:
+    static constexpr int kCache = 32, kNear = 4;
+    static constexpr uint32_t kEscape = kCache - kNear, kNone = kEscape + 1;
+
+    size_t count_;
+    size_t next_ = 0;
+    uint32_t cache_[kCache];
+    int size_ = 0;
+    uint16_t is_new_[3];
+    uint16_t is_near_[3];
+    rc_util::BitTreeModel<2> near_[3];
+    rc_util::BitTreeModel<5> far_[3];
+    rc_util::IntModel distance_;
+    bool ok_ = true;
+
+    // id to the front (from position k, or k == size_ when not cached)
+    void push(uint32_t id, int k) {
+      if (k == size_) {
+        if (size_ < kCache) ++size_;
+        k = size_ - 1;
+      }
+      for (; k > 0; --k) cache_[k] = cache_[k - 1];
+      cache_[0] = id;
+    };
+
+    int64_t fail() {
+      ok_ = false;
+      return 0;
+    };
+  };
+
+  bool decodeConnectivity(rc_util::RangeDecoder& rc, const MeshPackHeader& h,
+                          std::vector<uint32_t>& face_size, std::vector<int64_t>& he_vertex,
+                          std::vector<int64_t>& he_texcoord, std::vector<int64_t>& he_normal) {
+    const size_t nh = h.n_halfedges;
+    IndexCoder vcoder(h.n_vertices), tcoder(h.n_texcoords), ncoder(h.n_normals);
+    rc_util::IntModel size_model;
+    size_t j = 0;
+    for (auto& n : face_size) {
+      if (!(h.flags & MeshPackHeader::kTriangles)) n = size_model.decode(rc);
+      if ((n > nh - j) || rc.overrun()) return false;
+      for (uint32_t k = 0; k < n; ++k, ++j) {
+        const int ctx = std::min(k, 2u);
+        he_vertex[j] = vcoder.decode(rc, ctx);
+        if (he_vertex[j] < 0) return false;
+        if (!he_texcoord.empty()) he_texcoord[j] = tcoder.decode(rc, ctx);
+        if (!he_normal.empty()) he_normal[j] = ncoder.decode(rc, ctx);
+      }
+    }
+    return (j == nh) && vcoder.ok() && tcoder.ok() && ncoder.ok();
+  };
+
+  bool decodeAttributes(rc_util::RangeDecoder& rc, const MeshPackHeader& h,
+                        std::vector<Eigen::Vector3d>& points, std::vector<uint8_t>& has_color,
+                        std::vector<Eigen::Vector3d>& colors, std::vector<Eigen::Vector3d>& texcoords,
+                        std::vector<Eigen::Vector3d>& normals,
+                        std::vector<std::vector<std::pair<uint32_t, bool> > >& bloops) {
+    const size_t nv = h.n_vertices;
+    decodeValues(rc, h, MeshPackHeader::POSITION, nv, points);
+    if (h.flags & MeshPackHeader::kColors) {
+      has_color.resize(nv);
+      uint16_t prob = rc_util::kProbInit;
+      size_t nc = 0;
+      for (auto& c : has_color) nc += (c = (uint8_t) rc.decodeBit(prob));
+      decodeValues(rc, h, MeshPackHeader::COLOR, nc, colors);
+    }
+    decodeValues(rc, h, MeshPackHeader::TEXCOORD, h.n_texcoords, texcoords);
+    decodeValues(rc, h, MeshPackHeader::NORMAL, h.n_normals, normals);
+
+    // boundary loops (vertex ids, corner flags)
+    rc_util::IntModel count_model, id_model;
+    uint16_t corner_prob = rc_util::kProbInit;
+    for (auto& bl : bloops) {
+      const uint32_t n = count_model.decode(rc);
+      if ((n > nv) || rc.overrun()) return false;
+      int64_t prev = 0;
+      for (uint32_t i = 0; i < n; ++i) {
+        const int64_t id = prev + id_model.decodeSigned(rc);
+        const bool corner = rc.decodeBit(corner_prob) != 0;
+        if ((id < 0) || ((size_t) id >= nv)) return false;
+        bl.push_back(std::make_pair((uint32_t) id, corner));
+        prev = id;
+      }
+    }
+    return true;
+  };
+
+  // quantized values delta-coded in order; grid and error to the header
+  void encodeValues(rc_util::RangeEncoder& rc, MeshPackHeader& h, int a,
+                    const std::vector<Eigen::Vector3d>& v) {
+    if (v.empty()) return;
+    Eigen::Vector3d lo = v[0], hi = v[0];
+    for (auto& p : v) {
+      lo = lo.cwiseMin(p);
+      hi = hi.cwiseMax(p);
+    }
+    const double steps = (double) ((1u << bits_[a]) - 1);
+    const double extent = (hi - lo).maxCoeff();
+    const double cell = (extent > 0.0) ? extent / steps : 1.0;
+    for (int k = 0; k < 3; ++k) h.min[a][k] = lo[k];
+    h.cell[a] = cell;
+
+    rc_util::IntModel model[3];
+    int32_t prev[3] = {0, 0, 0};
+    double err = 0.0;
+    for (auto& p : v) {
+      Eigen::Vector3d d;
+      for (int k = 0; k < 3; ++k) {
+        const int32_t q = (int32_t) std::min(steps, std::max(0.0, std::floor((p[k] - lo[k]) / cell + 0.5)));
+        model[k].encodeSigned(rc, q - prev[k]);
+        prev[k] = q;
+        d[k] = lo[k] + q * cell - p[k];
+      }
+      err = std::max(err, d.norm());
+    }
+    h.max_error[a] = err;
+  };
+
+  void decodeValues(rc_util::RangeDecoder& rc, const MeshPackHeader& h, int a, size_t n,
+                    std::vector<Eigen::Vector3d>& v) {
+    v.resize(n);
+    rc_util::IntModel model[3];
+    int32_t prev[3] = {0, 0, 0};
+    for (auto& p : v) {
+      for (int k = 0; k < 3; ++k) {
+        prev[k] = (int32_t) ((uint32_t) prev[k] + (uint32_t) model[k].decodeSigned(rc));
+        p[k] = h.min[a][k] + prev[k] * h.cell[a];
+      }
+    }
+  };
+};
+
+#endif // _MESHPACKLIO_HXX
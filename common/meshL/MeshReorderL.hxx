@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////
+//
+// Cache-locality reordering of MeshL vertices and faces.
+//
+// Vertices are sorted along a Morton (Z-order) curve of their
+// positions; faces are ordered for a post-transform vertex cache with
+// Forsyth's linear-speed optimizer.  The result is applied through
+// MeshL::reorderVertices() / reorderFaces(), and the ACMR (average
+// cache miss ratio: vertex cache misses per triangle, FIFO cache) is
+// reported before and after.
+//
+//   MeshReorderL reorder(mesh);
+//   MeshReorderL::Stats st = reorder.apply();
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHREORDERL_HXX
+#define _MESHREORDERL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "myEigen.hxx"
+
+#include "MeshL.hxx"
+
+class MeshReorderL {
+
+ public:
+
+  struct Stats {
+    double acmr_before = 0.0;
+    double acmr_after = 0.0;
+  };
+
+  MeshReorderL(std::shared_ptr<MeshL> mesh) : mesh_(mesh) {};
+
+  // vertex cache size used by the optimizer and the ACMR
+  void setCacheSize(int n) { cache_size_ = std::max(4, n); };
+  int cacheSize() const { return cache_size_; };
+  void setVerbose(bool f) { verbose_ = f; };
+
+  //
+  // reorder faces (vertex cache) and vertices (spatial)
+  //
+  Stats apply(bool isFaces = true, bool isVertices = true) {
+    Stats st;
+    st.acmr_before = acmr();
+    if (isFaces) {
+      std::vector<int> order = cacheFaceOrder();
+      mesh_->reorderFaces(order);
+    }
+    if (isVertices) {
+      std::vector<int> order = spatialVertexOrder();
+      mesh_->reorderVertices(order);
+    }
+    st.acmr_after = acmr();
+    if (verbose_) {
+      std::cout << "reorder: ACMR " << st.acmr_before << " -> " << st.acmr_after
+                << " (cache " << cache_size_ << ")" << std::endl;
+    }
+    return st;
+  };
+
+  //
+  // ACMR of the current face order (0 if there are no faces)
+  //
+  double acmr() const { return acmr(cache_size_); };
+
+  double acmr(int cache_size) const {
+    Adjacency a;
+    buildAdjacency(a, false);
+    const int nf = (int) a.fv_offset.size() - 1;
+    // stamp[v]: time v entered the FIFO cache
+    std::vector<int64_t> stamp(a.nv, -(int64_t) cache_size - 1);
+    int64_t time = 0, misses = 0, tris = 0;
+    for (int f = 0; f < nf; ++f) {
+      const int b = a.fv_offset[f], e = a.fv_offset[f + 1];
+      for (int i = b; i < e; ++i) {
+        const int v = a.fv[i];
+        if (time - stamp[v] > cache_size) {
+          stamp[v] = time++;
+          ++misses;
+        }
+      }
+      if (e - b > 2) tris += e - b - 2;
+    }
+    return tris ? (double) misses / (double) tris : 0.0;
+  };
+
+  //
+  // face order for the vertex cache (list positions, see MeshL::reorderFaces)
+  //
+  // T. Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+  // Polygons are handled as a whole: all their vertices enter the cache.
+  //
+  std::vector<int> cacheFaceOrder() const {
+    Adjacency a;
+    buildAdjacency(a, true);
+    const int nf = (int) a.fv_offset.size() - 1;
+    const int nv = a.nv;
+    std::vector<int> order;
+    order.reserve(nf);
+    if (nf == 0) return order;
+
+    std::vector<int> live(nv);
+    for (int v = 0; v < nv; ++v) live[v] = a.vf_offset[v + 1] - a.vf_offset[v];
+    std::vector<int> cache_pos(nv, -1);
+    std::vector<double> vscore(nv);
+    for (int v = 0; v < nv; ++v) vscore[v] = vertexScore(-1, live[v]);
+
+    std::vector<double> fscore(nf, 0.0);
+    for (int f = 0; f < nf; ++f)
+      for (int i = a.fv_offset[f]; i < a.fv_offset[f + 1]; ++i) fscore[f] += vscore[a.fv[i]];
+    std::vector<char> emitted(nf, 0);
+
+    std::vector<int> cache, next_cache;
+    int best = 0;
+    int cursor = 0;
+    while ((int) order.size() < nf) {
+      if (best < 0) {
+        // dead end: the first face not yet emitted
+        while (emitted[cursor]) ++cursor;
+        best = cursor;
+      }
+      emitted[best] = 1;
+      order.push_back(best);
+
+      // emitted face's vertices move to the front of the LRU cache
+      next_cache.clear();
+      for (int i = a.fv_offset[best]; i < a.fv_offset[best + 1]; ++i) {
+        const int v = a.fv[i];
+        if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) {
+          next_cache.push_back(v);
+        }
+        --live[v];
+        // drop the face from v's list of live faces
+        int* fb = &a.vf[a.vf_offset[v]];
+        int* fe = fb + live[v] + 1;
+        *std::find(fb, fe, best) = fe[-1];
+      }
+      for (int v : cache)
+        if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end())
+          next_cache.push_back(v);
+      for (int v : cache) cache_pos[v] = -1;
+      cache.swap(next_cache);
+
+      // rescore the cached vertices (and the ones that fell out)
+      for (int p = 0; p < (int) cache.size(); ++p) {
+        const int v = cache[p];
+        cache_pos[v] = (p < cache_size_) ? p : -1;
+      }
+      best = -1;
+      double best_score = -1.0;
+      for (int v : cache) {
+        const double s = vertexScore(cache_pos[v], live[v]);
+        const double d = s - vscore[v];
+        vscore[v] = s;
+        for (int i = a.vf_offset[v]; i < a.vf_offset[v] + live[v]; ++i) {
+          const int f = a.vf[i];
+          fscore[f] += d;
+        }
+      }
+      for (int v : cache) {
+        for (int i = a.vf_offset[v]; i < a.vf_offset[v] + live[v]; ++i) {
+          const int f = a.vf[i];
+          if (fscore[f] > best_score) {
+            best_score = fscore[f];
+            best = f;
+          }
+        }
+      }
+      if ((int) cache.size() > cache_size_) cache.resize(cache_size_);
+    }
+    return order;
+  };
+
+  //
+  // vertex order along a Morton curve (list positions, see
+  // MeshL::reorderVertices)
+  //
+  std::vector<int> spatialVertexOrder() const {
+    const int nv = mesh_->vertices_size();
+    std::vector<int> order(nv);
+    if (nv == 0) return order;
+
+    Eigen::Vector3d vmin, vmax;
+    mesh_->computeBB(vmin, vmax);
+    const Eigen::Vector3d ext = vmax - vmin;
+    const double len = std::max(ext.maxCoeff(), 1.0e-300);
+    const double scale = (double) ((1 << 21) - 1) / len;
+
+    std::vector<std::pair<uint64_t, int> > keys(nv);
+    int i = 0;
+    for (auto& vt : mesh_->vertices()) {
+      const Eigen::Vector3d q = (vt->point() - vmin) * scale;
+      keys[i] = std::make_pair(mortonKey(quantize(q.x()), quantize(q.y()), quantize(q.z())), i);
+      ++i;
+    }
+    std::sort(keys.begin(), keys.end());
+    for (i = 0; i < nv; ++i) order[i] = keys[i].second;
+    return order;
+  };
+
+ private:
+
+  std::shared_ptr<MeshL> mesh_;
+  int cache_size_ = 32;
+  bool verbose_ = false;
+
+  // face-vertex (and vertex-face) CSR in list order
+  struct Adjacency {
+    int nv = 0;
+    std::vector<int> fv_offset, fv;
+    std::vector<int> vf_offset, vf;
+  };
+
+  void buildAdjacency(Adjacency& a, bool isVertexFaces) const {
+    // vertex ids may be sparse
+    int max_id = -1;
+    for (auto& vt : mesh_->vertices()) max_id = std::max(max_id, vt->id());
+    std::vector<int> index(max_id + 1, -1);
+    a.nv = 0;
+    for (auto& vt : mesh_->vertices()) index[vt->id()] = a.nv++;
+
+    a.fv_offset.assign(1, 0);
+    a.fv.clear();
+    for (auto& fc : mesh_->faces()) {
+      for (auto& he : fc->halfedges()) a.fv.push_back(index[he->vertex()->id()]);
+      a.fv_offset.push_back((int) a.fv.size());
+    }
+    if (!isVertexFaces) return;
+
+    const int nf = (int) a.fv_offset.size() - 1;
+    a.vf_offset.assign(a.nv + 1, 0);
+    for (int v : a.fv) ++a.vf_offset[v + 1];
+    for (int v = 0; v < a.nv; ++v) a.vf_offset[v + 1] += a.vf_offset[v];
+    a.vf.resize(a.fv.size());
+    std::vector<int> fill(a.vf_offset.begin(), a.vf_offset.end() - 1);
+    for (int f = 0; f < nf; ++f)
+      for (int i = a.fv_offset[f]; i < a.fv_offset[f + 1]; ++i) a.vf[fill[a.fv[i]]++] = f;
+  };
+
+  // Forsyth's vertex score (pos: LRU cache position, -1 if not cached)
+  double vertexScore(int pos, int live) const {
+    if (live <= 0) return -1.0;
+    double s = 0.0;
+    if (pos >= 0) {
+      if (pos < 3) {
+        s = 0.75;
+      } else {
+        const double x = 1.0 - (double) (pos - 3) / (double) (cache_size_ - 3);
+        s = std::pow(x, 1.5);
+      }
+    }
+    return s + 2.0 / std::sqrt((double) live);
+  };
+
+  static uint32_t quantize(double x) {
+    if (!(x > 0.0)) return 0;
+    if (x >= (double) ((1 << 21) - 1)) return (1 << 21) - 1;
+    return (uint32_t) x;
+  };
+
+  // spread the low 21 bits of x to every third bit
+  static uint64_t spreadBits(uint32_t x) {
+    uint64_t v = x & 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffULL;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+    v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+  };
+
+  static uint64_t mortonKey(uint32_t x, uint32_t y, uint32_t z) {
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+  };
+};
+
+#endif // _MESHREORDERL_HXX
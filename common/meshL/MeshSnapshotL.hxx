@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////////////
+//
+// Copy-on-write snapshots of a MeshL.
+//
+// A MeshSnapshotL holds the arrays of a CompactMesh split into chunks
+// of kChunkSize elements that are shared between copies.  Copying a
+// snapshot copies only the chunk pointers; writing to an element
+// (setPoint(), setMate(), ...) first clones its chunk if another
+// snapshot still uses it.  fromMeshL() can take the previous version
+// as a base: chunks whose contents did not change are taken over from
+// it, so a version costs memory proportional to the edited chunks.
+//
+// Limits: chunks are matched by list position, not by element id.
+// Edits in place (moved points, changed mates) and appended elements
+// share everything else with the base, but deleting or inserting an
+// element shifts the positions (and renumbers the indices) of all
+// later elements, so every chunk after the first deletion is copied.
+// fromMeshL() also builds a full CompactMesh of the mesh first, so
+// taking a version from a MeshL costs O(mesh) time and temporary
+// memory whatever the size of the edit; setPoint() etc. on a snapshot
+// cost only the chunks written.
+//
+//   MeshSnapshotL original(*mesh);
+//   ... edit mesh (cut, parameterize) ...
+//   MeshSnapshotL cut(*mesh, &original);  // shares unchanged chunks
+//   original.toMeshL(*other);             // back to a MeshL
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHSNAPSHOTL_HXX
+#define _MESHSNAPSHOTL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "myEigen.hxx"
+
+#include "MeshL.hxx"
+#include "CompactMesh.hxx"
+
+//
+// array of chunks shared between copies (copy on write)
+//
+template <class T>
+class CowArrayL {
+
+ public:
+
+  static constexpr size_t kChunkBits = 12;
+  static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+
+  size_t size() const { return size_; };
+  bool empty() const { return size_ == 0; };
+  void clear() { chunks_.clear(); size_ = 0; };
+
+  const T& operator[](size_t i) const { return (*chunks_[i >> kChunkBits])[i & kMask]; };
+
+  // clones the chunk of i when it is shared
+  T& write(size_t i) { return (*writableChunk(i >> kChunkBits))[i & kMask]; };
+
+  void push_back(const T& v) {
+    if ((size_ & kMask) == 0) {
+      chunks_.push_back(std::make_shared<Chunk>());
+      chunks_.back()->reserve(kChunkSize);
+    }
+    writableChunk(chunks_.size() - 1)->push_back(v);
+    ++size_;
+  };
+
+  // copies v; chunks equal to those of base at the same position are
+  // shared with base instead (after an insertion or deletion, none of
+  // the following chunks are)
+  void assign(const std::vector<T>& v, const CowArrayL* base = nullptr) {
+    clear();
+    size_ = v.size();
+    const size_t n = (size_ + kMask) >> kChunkBits;
+    chunks_.resize(n);
+    for (size_t c = 0; c < n; ++c) {
+      auto b = v.begin() + (c << kChunkBits);
+      auto e = v.begin() + std::min(size_, (c + 1) << kChunkBits);
+      if (base && (c < base->chunks_.size()) &&
+          (base->chunks_[c]->size() == (size_t)(e - b)) &&
+          std::equal(b, e, base->chunks_[c]->begin())) {
+        chunks_[c] = base->chunks_[c];
+      } else {
+        chunks_[c] = std::make_shared<Chunk>(b, e);
+      }
+    }
+  };
+
+  void toVector(std::vector<T>& v) const {
+    v.clear();
+    v.reserve(size_);
+    for (auto& c : chunks_) v.insert(v.end(), c->begin(), c->end());
+  };
+
+  // memory of all chunks / of the chunks used by no other snapshot
+  size_t bytes() const { return size_ * sizeof(T); };
+  size_t ownedBytes() const {
+    size_t b = 0;
+    for (auto& c : chunks_)
+      if (c.use_count() == 1) b += c->size() * sizeof(T);
+    return b;
+  };
+
+ private:
+
+  using Chunk = std::vector<T>;
+  static constexpr size_t kMask = kChunkSize - 1;
+
+  std::vector<std::shared_ptr<Chunk> > chunks_;
+  size_t size_ = 0;
+
+  Chunk* writableChunk(size_t c) {
+    if (chunks_[c].use_count() > 1) {
+      auto copy = std::make_shared<Chunk>();
+      copy->reserve(kChunkSize);
+      copy->assign(chunks_[c]->begin(), chunks_[c]->end());
+      chunks_[c] = copy;
+    }
+    return chunks_[c].get();
+  };
+};
+
+class MeshSnapshotL {
+
+ public:
+
+  using Index = CompactMesh::Index;
+  static constexpr Index kInvalid = CompactMesh::kInvalid;
+
+  MeshSnapshotL() {};
+  explicit MeshSnapshotL(MeshL& mesh, const MeshSnapshotL* base = nullptr) {
+    fromMeshL(mesh, base);
+  };
+
+  // copies share all chunks (default copy / assignment)
+
+  void clear() {
+    points_.clear();
+    colors_.clear();
+    v_halfedge_.clear();
+    texcoords_.clear();
+    normals_.clear();
+    he_vertex_.clear();
+    he_mate_.clear();
+    he_texcoord_.clear();
+    he_normal_.clear();
+    he_face_.clear();
+    f_offset_.clear();
+    n_faces_ = 0;
+    is_triangle_ = true;
+    is_mates_ = false;
+  };
+
+  //
+  // conversion
+  //
+  // O(mesh): goes through a full CompactMesh even with a base
+  void fromMeshL(MeshL& mesh, const MeshSnapshotL* base = nullptr) {
+    fromCompactMesh(CompactMesh(mesh), base);
+  };
+
+  void fromCompactMesh(const CompactMesh& cm, const MeshSnapshotL* base = nullptr) {
+    points_.assign(cm.points_, base ? &base->points_ : nullptr);
+    colors_.assign(cm.colors_, base ? &base->colors_ : nullptr);
+    v_halfedge_.assign(cm.v_halfedge_, base ? &base->v_halfedge_ : nullptr);
+    texcoords_.assign(cm.texcoords_, base ? &base->texcoords_ : nullptr);
+    normals_.assign(cm.normals_, base ? &base->normals_ : nullptr);
+    he_vertex_.assign(cm.he_vertex_, base ? &base->he_vertex_ : nullptr);
+    he_mate_.assign(cm.he_mate_, base ? &base->he_mate_ : nullptr);
+    he_texcoord_.assign(cm.he_texcoord_, base ? &base->he_texcoord_ : nullptr);
+    he_normal_.assign(cm.he_normal_, base ? &base->he_normal_ : nullptr);
+    he_face_.assign(cm.he_face_, base ? &base->he_face_ : nullptr);
+    f_offset_.assign(cm.f_offset_, base ? &base->f_offset_ : nullptr);
+    n_faces_ = cm.n_faces_;
+    is_triangle_ = cm.is_triangle_;
+    is_mates_ = cm.is_mates_;
+  };
+
+  void toCompactMesh(CompactMesh& cm) const {
+    cm.clear();
+    points_.toVector(cm.points_);
+    colors_.toVector(cm.colors_);
+    v_halfedge_.toVector(cm.v_halfedge_);
+    texcoords_.toVector(cm.texcoords_);
+    normals_.toVector(cm.normals_);
+    he_vertex_.toVector(cm.he_vertex_);
+    he_mate_.toVector(cm.he_mate_);
+    he_texcoord_.toVector(cm.he_texcoord_);
+    he_normal_.toVector(cm.he_normal_);
+    he_face_.toVector(cm.he_face_);
+    f_offset_.toVector(cm.f_offset_);
+    cm.n_faces_ = n_faces_;
+    cm.is_triangle_ = is_triangle_;
+    cm.is_mates_ = is_mates_;
+  };
+
+  // mesh is cleared (see CompactMesh::toMeshL)
+  void toMeshL(MeshL& mesh, bool isCreateConnectivity = true) const {
+    CompactMesh cm;
+    toCompactMesh(cm);
+    cm.toMeshL(mesh, isCreateConnectivity);
+  };
+
+  // sizes
+  Index numVertices() const { return (Index)points_.size(); };
+  Index numFaces() const { return n_faces_; };
+  Index numHalfedges() const { return (Index)he_vertex_.size(); };
+  bool isTriangleMesh() const { return is_triangle_; };
+  bool hasColors() const { return !colors_.empty(); };
+  bool isMates() const { return is_mates_; };
+
+  //
+  // read access (same handles as CompactMesh)
+  //
+  const Eigen::Vector3d& point(Index v) const { return points_[v]; };
+  const Eigen::Vector3d& color(Index v) const { return colors_[v]; };
+  Index vertexHalfedge(Index v) const { return v_halfedge_[v]; };
+  const Eigen::Vector3d& texcoord(Index t) const { return texcoords_[t]; };
+  const Eigen::Vector3d& normal(Index n) const { return normals_[n]; };
+
+  Index faceBegin(Index f) const { return is_triangle_ ? 3 * f : f_offset_[f]; };
+  int faceSize(Index f) const {
+    return is_triangle_ ? 3 : (int)(f_offset_[f + 1] - f_offset_[f]);
+  };
+
+  Index vertex(Index h) const { return he_vertex_[h]; };
+  Index face(Index h) const { return is_triangle_ ? h / 3 : he_face_[h]; };
+  Index next(Index h) const {
+    if (is_triangle_) return (h % 3 == 2) ? h - 2 : h + 1;
+    const Index f = he_face_[h];
+    return (h + 1 == f_offset_[f + 1]) ? f_offset_[f] : h + 1;
+  };
+  Index prev(Index h) const {
+    if (is_triangle_) return (h % 3 == 0) ? h + 2 : h - 1;
+    const Index f = he_face_[h];
+    return (h == f_offset_[f]) ? f_offset_[f + 1] - 1 : h - 1;
+  };
+  Index mate(Index h) const { return he_mate_[h]; };
+
+  //
+  // write access (copies the chunk on first write)
+  //
+  void setPoint(Index v, const Eigen::Vector3d& p) { points_.write(v) = p; };
+  void setColor(Index v, const Eigen::Vector3d& c) {
+    if (colors_.empty())
+      for (Index i = 0; i < numVertices(); ++i) colors_.push_back(Eigen::Vector3d::Zero());
+    colors_.write(v) = c;
+  };
+  void setTexcoord(Index t, const Eigen::Vector3d& p) { texcoords_.write(t) = p; };
+  void setNormal(Index n, const Eigen::Vector3d& p) { normals_.write(n) = p; };
+  void setMate(Index h, Index m) { he_mate_.write(h) = m; };
+  void setVertexHalfedge(Index v, Index h) { v_halfedge_.write(v) = h; };
+
+  // memory of the arrays / of the chunks shared with no other snapshot
+  size_t bytes() const {
+    return points_.bytes() + colors_.bytes() + v_halfedge_.bytes() +
+           texcoords_.bytes() + normals_.bytes() + he_vertex_.bytes() +
+           he_mate_.bytes() + he_texcoord_.bytes() + he_normal_.bytes() +
+           he_face_.bytes() + f_offset_.bytes();
+  };
+  size_t ownedBytes() const {
+    return points_.ownedBytes() + colors_.ownedBytes() + v_halfedge_.ownedBytes() +
+           texcoords_.ownedBytes() + normals_.ownedBytes() + he_vertex_.ownedBytes() +
+           he_mate_.ownedBytes() + he_texcoord_.ownedBytes() + he_normal_.ownedBytes() +
+           he_face_.ownedBytes() + f_offset_.ownedBytes();
+  };
+
+ private:
+
+  // vertices
+  CowArrayL<Eigen::Vector3d> points_;
+  CowArrayL<Eigen::Vector3d> colors_;
+  CowArrayL<Index> v_halfedge_;
+
+  // texcoords, normals
+  CowArrayL<Eigen::Vector3d> texcoords_;
+  CowArrayL<Eigen::Vector3d> normals_;
+
+  // halfedges
+  CowArrayL<Index> he_vertex_;
+  CowArrayL<Index> he_mate_;
+  CowArrayL<Index> he_texcoord_;
+  CowArrayL<Index> he_normal_;
+  CowArrayL<Index> he_face_;   // empty while triangle-only
+
+  // faces
+  CowArrayL<Index> f_offset_;  // empty while triangle-only
+  Index n_faces_ = 0;
+  bool is_triangle_ = true;
+
+  bool is_mates_ = false;
+};
+
+#endif // _MESHSNAPSHOTL_HXX
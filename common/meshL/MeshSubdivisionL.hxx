@@ -0,0 +1,336 @@
+////////////////////////////////////////////////////////////////////
+//
+// Loop / Catmull-Clark subdivision with precomputed stencils.
+//
+// build() refines the topology of the cage once (on index arrays, not
+// by Euler operations) and composes the refinement matrices of all
+// levels into a single sparse stencil table S: refined point i is
+// sum_j S(i, j) * control point j.  Moving the cage afterwards only
+// needs apply() / update(), a parallel sparse matrix-vector product.
+//
+// Refined vertices are ordered as: vertex points of the last level,
+// then its edge points, then (Catmull-Clark) its face points.
+// Boundary edges are kept as creases (cubic B-spline curves); vertices
+// with one or more than two boundary edges are kept as corners.
+// Texcoords and normals are not subdivided.  The stencils are tied to
+// the cage vertices at build(): apply() / toMeshL() / update() return
+// false when the cage has gained or lost vertices since (build() again).
+//
+//   MeshSubdivisionL subd(cage);
+//   subd.build(MeshSubdivisionL::CATMULL_CLARK, 2);
+//   subd.toMeshL(*refined);                // once
+//   ... move cage vertices ...
+//   subd.update(*refined);                 // per frame
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHSUBDIVISIONL_HXX
+#define _MESHSUBDIVISIONL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "myEigen.hxx"
+
+#include "MeshL.hxx"
+#include "CompactMesh.hxx"
+#include "ParallelFor.hxx"
+
+class MeshSubdivisionL {
+
+ public:
+
+  enum Scheme { LOOP = 0, CATMULL_CLARK = 1 };
+
+  using Stencils = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+  MeshSubdivisionL(std::shared_ptr<MeshL> cage) : cage_(cage) {};
+
+  //
+  // refines the topology levels times and builds the stencils.
+  // Loop needs a triangle mesh (false otherwise).
+  //
+  bool build(Scheme scheme, int levels = 1) {
+    std::vector<int> offset(1, 0), fvertex;
+    int nv = (int) cage_->vertices_size();
+    {
+      std::vector<int> vindex;
+      int i = 0;
+      for (auto& vt : cage_->vertices()) {
+        if (vt->id() >= (int) vindex.size()) vindex.resize(vt->id() + 1, -1);
+        vindex[vt->id()] = i++;
+      }
+      for (auto& fc : cage_->faces()) {
+        for (auto& he : fc->halfedges()) fvertex.push_back(vindex[he->vertex()->id()]);
+        offset.push_back((int) fvertex.size());
+        if ((scheme == LOOP) && (offset.back() - offset[offset.size() - 2] != 3)) return false;
+      }
+    }
+
+    Stencils S(nv, nv);
+    S.setIdentity();
+    for (int l = 0; l < levels; ++l) {
+      std::vector<int> offset2, fvertex2;
+      int nv2 = 0;
+      std::vector<Eigen::Triplet<double> > t;
+      refine(scheme, nv, offset, fvertex, nv2, offset2, fvertex2, t);
+      Stencils P(nv2, nv);
+      P.setFromTriplets(t.begin(), t.end());
+      S = P * S;
+      nv = nv2;
+      offset.swap(offset2);
+      fvertex.swap(fvertex2);
+    }
+    stencils_ = S;
+    stencils_.makeCompressed();
+    f_offset_.swap(offset);
+    f_vertex_.swap(fvertex);
+    return true;
+  };
+
+  const Stencils& stencils() const { return stencils_; };
+  int numVertices() const { return (int) stencils_.rows(); };
+  // cage vertex count at build()
+  int numControlVertices() const { return (int) stencils_.cols(); };
+  int numFaces() const { return f_offset_.empty() ? 0 : (int) f_offset_.size() - 1; };
+  // refined faces: vertices f_vertex[f_offset[f] .. f_offset[f+1])
+  const std::vector<int>& faceOffsets() const { return f_offset_; };
+  const std::vector<int>& faceVertices() const { return f_vertex_; };
+
+  //
+  // refined points of control (in the order of the cage vertex list);
+  // false when control does not have numControlVertices() points
+  //
+  bool apply(const std::vector<Eigen::Vector3d>& control,
+             std::vector<Eigen::Vector3d>& points) const {
+    if ((int) control.size() != numControlVertices()) return false;
+    points.resize(stencils_.rows());
+    const int* outer = stencils_.outerIndexPtr();
+    const int* inner = stencils_.innerIndexPtr();
+    const double* w = stencils_.valuePtr();
+    const Eigen::Vector3d* p = control.data();
+    par_util::parallelFor(0, points.size(), [&](size_t i) {
+      Eigen::Vector3d q = Eigen::Vector3d::Zero();
+      for (int k = outer[i]; k < outer[i + 1]; ++k) q += w[k] * p[inner[k]];
+      points[i] = q;
+    }, 1 << 12);
+    return true;
+  };
+
+  // refined mesh at the current cage (mesh is cleared; left untouched
+  // when the cage no longer matches the stencils)
+  bool toMeshL(MeshL& mesh) const {
+    std::vector<Eigen::Vector3d> points;
+    if (!apply(cagePoints(), points)) return false;
+    CompactMesh cm;
+    cm.reserve((CompactMesh::Index) points.size(), numFaces(), (CompactMesh::Index) f_vertex_.size());
+    for (auto& p : points) cm.addVertex(p);
+    for (int f = 0; f < numFaces(); ++f)
+      cm.addFace(&f_vertex_[f_offset_[f]], f_offset_[f + 1] - f_offset_[f]);
+    cm.toMeshL(mesh);
+    return true;
+  };
+
+  // moves the vertices of a mesh made by toMeshL() to the current cage
+  bool update(MeshL& mesh) const {
+    std::vector<Eigen::Vector3d> points;
+    if (!apply(cagePoints(), points)) return false;
+    size_t i = 0;
+    for (auto& vt : mesh.vertices()) {
+      if (i == points.size()) break;
+      vt->point() = points[i++];
+    }
+    return true;
+  };
+
+ private:
+
+  std::shared_ptr<MeshL> cage_;
+  Stencils stencils_;
+  std::vector<int> f_offset_;
+  std::vector<int> f_vertex_;
+
+  std::vector<Eigen::Vector3d> cagePoints() const {
+    std::vector<Eigen::Vector3d> p;
+    p.reserve(cage_->vertices_size());
+    for (auto& vt : cage_->vertices()) p.push_back(vt->point());
+    return p;
+  };
+
+  //
+  // one level: new faces (offset2, fvertex2) and the refinement matrix
+  // (triplets, nv2 x nv)
+  //
+  static void refine(Scheme scheme, int nv,
+                     const std::vector<int>& offset, const std::vector<int>& fvertex,
+                     int& nv2, std::vector<int>& offset2, std::vector<int>& fvertex2,
+                     std::vector<Eigen::Triplet<double> >& t) {
+    const int nf = (int) offset.size() - 1;
+    const int nh = (int) fvertex.size();
+    std::vector<int> hface(nh), hnext(nh), hprev(nh);
+    for (int f = 0; f < nf; ++f)
+      for (int h = offset[f]; h < offset[f + 1]; ++h) {
+        hface[h] = f;
+        hnext[h] = (h + 1 < offset[f + 1]) ? h + 1 : offset[f];
+        hprev[h] = (h > offset[f]) ? h - 1 : offset[f + 1] - 1;
+      }
+
+    // edges: corners sorted by (min, max) vertex
+    std::vector<std::pair<uint64_t, int> > keys(nh);
+    for (int h = 0; h < nh; ++h)
+      keys[h] = std::make_pair(CompactMesh::edgeKey(fvertex[h], fvertex[hnext[h]]), h);
+    std::sort(keys.begin(), keys.end());
+    std::vector<int> hedge(nh);
+    std::vector<int> ehalf, enum_faces;  // first corner, number of corners
+    for (size_t i = 0; i < keys.size();) {
+      size_t j = i + 1;
+      while ((j < keys.size()) && (keys[j].first == keys[i].first)) ++j;
+      const int e = (int) ehalf.size();
+      for (size_t k = i; k < j; ++k) hedge[keys[k].second] = e;
+      ehalf.push_back(keys[i].second);
+      enum_faces.push_back((int) (j - i));
+      i = j;
+    }
+    const int ne = (int) ehalf.size();
+    // the other corner of an interior edge
+    std::vector<int> emate(ne, -1);
+    for (int h = 0; h < nh; ++h)
+      if (h != ehalf[hedge[h]]) emate[hedge[h]] = h;
+
+    // vertex -> edges, corners
+    std::vector<int> vedge_off(nv + 1, 0), vcorner_off(nv + 1, 0);
+    for (int e = 0; e < ne; ++e) {
+      ++vedge_off[fvertex[ehalf[e]] + 1];
+      ++vedge_off[fvertex[hnext[ehalf[e]]] + 1];
+    }
+    for (int h = 0; h < nh; ++h) ++vcorner_off[fvertex[h] + 1];
+    for (int v = 0; v < nv; ++v) {
+      vedge_off[v + 1] += vedge_off[v];
+      vcorner_off[v + 1] += vcorner_off[v];
+    }
+    std::vector<int> vedge(vedge_off[nv]), vcorner(vcorner_off[nv]);
+    {
+      std::vector<int> pe(vedge_off.begin(), vedge_off.end() - 1);
+      for (int e = 0; e < ne; ++e) {
+        vedge[pe[fvertex[ehalf[e]]]++] = e;
+        vedge[pe[fvertex[hnext[ehalf[e]]]]++] = e;
+      }
+      std::vector<int> pc(vcorner_off.begin(), vcorner_off.end() - 1);
+      for (int h = 0; h < nh; ++h) vcorner[pc[fvertex[h]]++] = h;
+    }
+    auto other = [&](int e, int v) {
+      const int a = fvertex[ehalf[e]];
+      return (a == v) ? fvertex[hnext[ehalf[e]]] : a;
+    };
+
+    const bool is_cc = (scheme == CATMULL_CLARK);
+    nv2 = nv + ne + (is_cc ? nf : 0);
+    t.clear();
+    t.reserve((size_t) 8 * nv2);
+
+    // vertex points
+    for (int v = 0; v < nv; ++v) {
+      const int n = vedge_off[v + 1] - vedge_off[v];
+      int nb = 0, b[2] = {-1, -1};
+      for (int k = vedge_off[v]; k < vedge_off[v + 1]; ++k) {
+        const int e = vedge[k];
+        if (enum_faces[e] == 2) continue;
+        if (nb < 2) b[nb] = other(e, v);
+        ++nb;
+      }
+      if ((n == 0) || (nb == 1) || (nb > 2)) {
+        t.emplace_back(v, v, 1.0);  // corner / isolated
+      } else if (nb == 2) {
+        t.emplace_back(v, v, 0.75);
+        t.emplace_back(v, b[0], 0.125);
+        t.emplace_back(v, b[1], 0.125);
+      } else if (!is_cc) {
+        const double c = 0.375 + 0.25 * std::cos(2.0 * M_PI / n);
+        const double beta = (0.625 - c * c) / n;
+        t.emplace_back(v, v, 1.0 - n * beta);
+        for (int k = vedge_off[v]; k < vedge_off[v + 1]; ++k)
+          t.emplace_back(v, other(vedge[k], v), beta);
+      } else {
+        // (F + 2R + (n - 3) V) / n
+        const double nn = (double) n * n;
+        t.emplace_back(v, v, (n - 2.0) / n);
+        for (int k = vedge_off[v]; k < vedge_off[v + 1]; ++k)
+          t.emplace_back(v, other(vedge[k], v), 1.0 / nn);
+        for (int k = vcorner_off[v]; k < vcorner_off[v + 1]; ++k) {
+          const int f = hface[vcorner[k]];
+          const double w = 1.0 / (nn * (offset[f + 1] - offset[f]));
+          for (int h = offset[f]; h < offset[f + 1]; ++h) t.emplace_back(v, fvertex[h], w);
+        }
+      }
+    }
+
+    // edge points
+    for (int e = 0; e < ne; ++e) {
+      const int r = nv + e;
+      const int h0 = ehalf[e];
+      const int a = fvertex[h0], b = fvertex[hnext[h0]];
+      if ((enum_faces[e] != 2) || (emate[e] < 0)) {
+        t.emplace_back(r, a, 0.5);
+        t.emplace_back(r, b, 0.5);
+      } else if (!is_cc) {
+        t.emplace_back(r, a, 0.375);
+        t.emplace_back(r, b, 0.375);
+        t.emplace_back(r, fvertex[hprev[h0]], 0.125);
+        t.emplace_back(r, fvertex[hprev[emate[e]]], 0.125);
+      } else {
+        t.emplace_back(r, a, 0.25);
+        t.emplace_back(r, b, 0.25);
+        for (int f : {hface[h0], hface[emate[e]]}) {
+          const double w = 0.25 / (offset[f + 1] - offset[f]);
+          for (int h = offset[f]; h < offset[f + 1]; ++h) t.emplace_back(r, fvertex[h], w);
+        }
+      }
+    }
+
+    // face points
+    if (is_cc) {
+      for (int f = 0; f < nf; ++f) {
+        const double w = 1.0 / (offset[f + 1] - offset[f]);
+        for (int h = offset[f]; h < offset[f + 1]; ++h) t.emplace_back(nv + ne + f, fvertex[h], w);
+      }
+    }
+
+    // faces
+    offset2.assign(1, 0);
+    fvertex2.clear();
+    if (!is_cc) {
+      offset2.reserve(4 * nf + 1);
+      fvertex2.reserve(12 * nf);
+      for (int f = 0; f < nf; ++f) {
+        const int h0 = offset[f], h1 = h0 + 1, h2 = h0 + 2;
+        const int e0 = nv + hedge[h0], e1 = nv + hedge[h1], e2 = nv + hedge[h2];
+        const int tri[4][3] = {{fvertex[h0], e0, e2}, {fvertex[h1], e1, e0},
+                               {fvertex[h2], e2, e1}, {e0, e1, e2}};
+        for (auto& q : tri) {
+          fvertex2.insert(fvertex2.end(), q, q + 3);
+          offset2.push_back((int) fvertex2.size());
+        }
+      }
+    } else {
+      offset2.reserve(nh + 1);
+      fvertex2.reserve(4 * nh);
+      for (int f = 0; f < nf; ++f)
+        for (int h = offset[f]; h < offset[f + 1]; ++h) {
+          const int quad[4] = {fvertex[h], nv + hedge[h], nv + ne + f, nv + hedge[hprev[h]]};
+          fvertex2.insert(fvertex2.end(), quad, quad + 4);
+          offset2.push_back((int) fvertex2.size());
+        }
+    }
+  };
+};
+
+#endif // _MESHSUBDIVISIONL_HXX
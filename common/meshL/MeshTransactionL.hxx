@@ -0,0 +1,315 @@
+////////////////////////////////////////////////////////////////////
+//
+// Undo / redo log of MeshL edits.
+//
+// A MeshTransactionL is set as the edit log of a mesh
+// (MeshL::setEditLog) while a batch of edits runs.  The first time an
+// element is touched its state is saved; element additions and
+// deletions are recorded with the element that followed them in the
+// mesh list.  close() saves the new states, after which undo() and
+// redo() switch between the two in time proportional to the number of
+// changed elements.  Only vertices, faces and halfedges are logged.
+//
+//   MeshTransactionL tr(mesh.get());
+//   mesh->setEditLog(&tr);
+//   ... edits ...
+//   mesh->setEditLog(nullptr);
+//   tr.close();
+//   tr.undo();
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHTRANSACTIONL_HXX
+#define _MESHTRANSACTIONL_HXX 1
+
+#include "envDep.h"
+
+#include <iterator>
+#include <list>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "myEigen.hxx"
+
+#include "MeshL.hxx"
+
+class MeshTransactionL : public MeshEditLogL {
+
+ public:
+
+  explicit MeshTransactionL(MeshL* mesh) : mesh_(mesh) {
+    v_id_[0] = v_id_[1] = mesh_->v_id_;
+    f_id_[0] = f_id_[1] = mesh_->f_id_;
+    h_id_[0] = h_id_[1] = mesh_->h_id_;
+  };
+
+  //
+  // MeshEditLogL
+  //
+  void touch(const std::shared_ptr<VertexL>& vt) override {
+    if (!vt || !v_seen_.insert(vt.get()).second) return;
+    vertices_.push_back(Entry<VertexL, VertexState>{vt, save(*vt), VertexState()});
+  };
+
+  void touch(const std::shared_ptr<FaceL>& fc) override {
+    if (!fc || !f_seen_.insert(fc.get()).second) return;
+    faces_.push_back(Entry<FaceL, FaceState>{fc, save(*fc), FaceState()});
+  };
+
+  void touch(const std::shared_ptr<HalfedgeL>& he) override {
+    if (!he || !h_seen_.insert(he.get()).second) return;
+    halfedges_.push_back(Entry<HalfedgeL, HalfedgeState>{he, save(*he), HalfedgeState()});
+  };
+
+  void added(const std::shared_ptr<VertexL>& vt) override {
+    touch(vt);
+    v_ops_.push_back(ListOp<VertexL>{true, vt, follower(vt->iter(), mesh_->vertices_)});
+  };
+
+  void added(const std::shared_ptr<FaceL>& fc) override {
+    touch(fc);
+    f_ops_.push_back(ListOp<FaceL>{true, fc, follower(fc->iter(), mesh_->faces_)});
+  };
+
+  void added(const std::shared_ptr<HalfedgeL>& he) override {
+    touch(he);
+    h_ops_.push_back(ListOp<HalfedgeL>{true, he, follower(he->meshIter(), mesh_->halfedges_)});
+  };
+
+  void removing(const std::shared_ptr<VertexL>& vt) override {
+    touch(vt);
+    v_ops_.push_back(ListOp<VertexL>{false, vt, follower(vt->iter(), mesh_->vertices_)});
+  };
+
+  void removing(const std::shared_ptr<FaceL>& fc) override {
+    touch(fc);
+    f_ops_.push_back(ListOp<FaceL>{false, fc, follower(fc->iter(), mesh_->faces_)});
+  };
+
+  // MeshL::deleteHalfedge also clears the mate, the vertex's halfedge
+  // and the face list entry
+  void removing(const std::shared_ptr<HalfedgeL>& he) override {
+    touch(he);
+    if (he->mate()) touch(he->mate());
+    if (he->vertex()) touch(he->vertex());
+    if (he->face()) touch(he->face());
+    if (he->meshIter() == mesh_->halfedges_.end()) return;
+    h_ops_.push_back(ListOp<HalfedgeL>{false, he, follower(he->meshIter(), mesh_->halfedges_)});
+  };
+
+  //
+  // after the last edit: saves the new states (needed by redo())
+  //
+  void close() {
+    for (auto& e : vertices_) e.after = save(*e.e);
+    for (auto& e : faces_) e.after = save(*e.e);
+    for (auto& e : halfedges_) e.after = save(*e.e);
+    v_id_[1] = mesh_->v_id_;
+    f_id_[1] = mesh_->f_id_;
+    h_id_[1] = mesh_->h_id_;
+    // nothing more is touched
+    v_seen_.clear();
+    f_seen_.clear();
+    h_seen_.clear();
+  };
+
+  // back to the state before the first edit
+  void undo() {
+    restore(false);
+    for (auto it = v_ops_.rbegin(); it != v_ops_.rend(); ++it) replay(*it, !it->add);
+    for (auto it = f_ops_.rbegin(); it != f_ops_.rend(); ++it) replay(*it, !it->add);
+    for (auto it = h_ops_.rbegin(); it != h_ops_.rend(); ++it) replay(*it, !it->add);
+    finish(0);
+  };
+
+  // the state at close()
+  void redo() {
+    restore(true);
+    for (auto& op : v_ops_) replay(op, op.add);
+    for (auto& op : f_ops_) replay(op, op.add);
+    for (auto& op : h_ops_) replay(op, op.add);
+    finish(1);
+  };
+
+  bool empty() const {
+    return vertices_.empty() && faces_.empty() && halfedges_.empty();
+  };
+
+  // number of saved element states and list changes
+  size_t size() const {
+    return vertices_.size() + faces_.size() + halfedges_.size() +
+           v_ops_.size() + f_ops_.size() + h_ops_.size();
+  };
+
+ private:
+
+  struct VertexState {
+    int id = -1;
+    Eigen::Vector3d point = Eigen::Vector3d::Zero();
+    std::shared_ptr<HalfedgeL> halfedge;
+  };
+
+  struct FaceState {
+    int id = -1;
+    Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+    std::vector<std::shared_ptr<HalfedgeL> > halfedges;
+  };
+
+  struct HalfedgeState {
+    int id = -1;
+    std::shared_ptr<VertexL> vertex;
+    std::shared_ptr<HalfedgeL> mate;
+    std::shared_ptr<FaceL> face;
+    std::shared_ptr<NormalL> normal;
+    std::shared_ptr<TexcoordL> texcoord;
+    std::shared_ptr<EdgeL> edge;
+  };
+
+  template <class T, class S>
+  struct Entry {
+    std::shared_ptr<T> e;
+    S before, after;
+  };
+
+  // add (true) or removal of e; follower: the next element in the list
+  // at that time (nullptr: the end)
+  template <class T>
+  struct ListOp {
+    bool add;
+    std::shared_ptr<T> e;
+    std::shared_ptr<T> follower;
+  };
+
+  MeshL* mesh_;
+
+  std::vector<Entry<VertexL, VertexState> > vertices_;
+  std::vector<Entry<FaceL, FaceState> > faces_;
+  std::vector<Entry<HalfedgeL, HalfedgeState> > halfedges_;
+  std::unordered_set<const VertexL*> v_seen_;
+  std::unordered_set<const FaceL*> f_seen_;
+  std::unordered_set<const HalfedgeL*> h_seen_;
+
+  std::vector<ListOp<VertexL> > v_ops_;
+  std::vector<ListOp<FaceL> > f_ops_;
+  std::vector<ListOp<HalfedgeL> > h_ops_;
+
+  // id counters before / after
+  int v_id_[2], f_id_[2], h_id_[2];
+
+  static VertexState save(VertexL& vt) {
+    VertexState s;
+    s.id = vt.id();
+    s.point = vt.point();
+    s.halfedge = vt.halfedge();
+    return s;
+  };
+
+  static FaceState save(FaceL& fc) {
+    FaceState s;
+    s.id = fc.id();
+    s.normal = fc.normal();
+    s.halfedges.assign(fc.halfedges().begin(), fc.halfedges().end());
+    return s;
+  };
+
+  static HalfedgeState save(HalfedgeL& he) {
+    HalfedgeState s;
+    s.id = he.id();
+    s.vertex = he.vertex();
+    s.mate = he.mate();
+    s.face = he.face();
+    s.normal = he.normal();
+    s.texcoord = he.texcoord();
+    s.edge = he.edge();
+    return s;
+  };
+
+  template <class T>
+  static std::shared_ptr<T> follower(typename std::list<std::shared_ptr<T> >::iterator it,
+                                     std::list<std::shared_ptr<T> >& l) {
+    if (it == l.end()) return nullptr;
+    ++it;
+    return (it == l.end()) ? nullptr : *it;
+  };
+
+  // element states: halfedges first, then face lists (which reseat the
+  // face iterators of their halfedges)
+  void restore(bool isAfter) {
+    for (auto& e : halfedges_) {
+      const HalfedgeState& s = isAfter ? e.after : e.before;
+      HalfedgeL& he = *e.e;
+      he.setID(s.id);
+      he.setVertex(s.vertex);
+      he.setMate(s.mate);
+      // setFace() resets the face iterator; only when it moved
+      if (he.face() != s.face) he.setFace(s.face);
+      he.setNormal(s.normal);
+      he.setTexcoord(s.texcoord);
+      he.setEdge(s.edge);
+    }
+    for (auto& e : vertices_) {
+      const VertexState& s = isAfter ? e.after : e.before;
+      e.e->setID(s.id);
+      e.e->point() = s.point;
+      e.e->setHalfedge(s.halfedge);
+    }
+    for (auto& e : faces_) {
+      const FaceState& s = isAfter ? e.after : e.before;
+      FaceL& fc = *e.e;
+      fc.setID(s.id);
+      fc.normal() = s.normal;
+      auto& hlist = fc.halfedges();
+      hlist.assign(s.halfedges.begin(), s.halfedges.end());
+      for (auto it = hlist.begin(); it != hlist.end(); ++it)
+        (*it)->setFaceandFIter(e.e, it, hlist);
+    }
+  };
+
+  // add (isAdd) or remove op.e at its logged position
+  void replay(const ListOp<VertexL>& op, bool isAdd) {
+    if (isAdd) {
+      auto pos = op.follower ? op.follower->iter() : mesh_->vertices_.end();
+      op.e->setIter(mesh_->vertices_.insert(pos, op.e));
+      mesh_->v_index_.insert(op.e);
+    } else {
+      mesh_->v_index_.erase(op.e);
+      mesh_->vertices_.erase(op.e->iter());
+    }
+  };
+
+  void replay(const ListOp<FaceL>& op, bool isAdd) {
+    if (isAdd) {
+      auto pos = op.follower ? op.follower->iter() : mesh_->faces_.end();
+      op.e->setIter(mesh_->faces_.insert(pos, op.e));
+      mesh_->f_index_.insert(op.e);
+    } else {
+      mesh_->f_index_.erase(op.e);
+      mesh_->faces_.erase(op.e->iter());
+    }
+  };
+
+  void replay(const ListOp<HalfedgeL>& op, bool isAdd) {
+    if (isAdd) {
+      auto pos = op.follower ? op.follower->meshIter() : mesh_->halfedges_.end();
+      op.e->setMeshIter(mesh_->halfedges_.insert(pos, op.e));
+      mesh_->h_index_.insert(op.e);
+    } else {
+      mesh_->h_index_.erase(op.e);
+      mesh_->halfedges_.erase(op.e->meshIter());
+      op.e->setMeshIter(mesh_->halfedges_.end());
+    }
+  };
+
+  void finish(int i) {
+    mesh_->v_id_ = v_id_[i];
+    mesh_->f_id_ = f_id_[i];
+    mesh_->h_id_ = h_id_[i];
+    mesh_->touchTopology();
+  };
+};
+
+#endif // _MESHTRANSACTIONL_HXX
@@ -13,86 +13,76 @@
 #include "envDep.h"
 #include <list>
 #include <memory>
-#include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "HalfedgeL.hxx"
 #include "VertexL.hxx"
 #include "VertexLCirculator.hxx"
+#include "VertexLRawCirculator.hxx"
 
 //
 // VertexL utility
 //
 
 inline std::shared_ptr<HalfedgeL> findHalfedge( std::shared_ptr<VertexL> o, std::shared_ptr<VertexL> vt ) {
-  VertexLCirculator vc( o );
-  std::shared_ptr<HalfedgeL> he = vc.beginHalfedgeL();
-  do {
-    if ( he->next()->vertex() == vt ) return he;
+  const VertexL* v = vt.get();
+  for ( HalfedgeL* he : VertexLRawCirculator( o.get() ).halfedges() ) {
+    if ( he->nextRaw()->vertexRaw() == v ) return he->shared_from_this();
 
-    std::shared_ptr<HalfedgeL> mate = he->mate();
+    HalfedgeL* mate = he->mateRaw();
     if ( mate )
       {
-        if ( mate->vertex() == vt ) return mate;
+        if ( mate->vertexRaw() == v ) return mate->shared_from_this();
       }
-    he = vc.nextHalfedgeL();
-  } while ( (he != nullptr) && (he != vc.firstHalfedgeL()) );
+  }
 
   return nullptr;
 }
 
 inline void reset_halfedge( std::shared_ptr<VertexL> vt ) {
-  if ( vt->halfedge() == nullptr ) return;
-  std::shared_ptr<HalfedgeL> he = vt->halfedge();
-  if ( he->mate() == nullptr ) return;
+  HalfedgeL* first = vt->halfedgeRaw();
+  if ( first == nullptr ) return;
+  HalfedgeL* he = first;
+  if ( he->mateRaw() == nullptr ) return;
   do {
-    he = he->mate()->next();
-  } while ( (he->mate() != nullptr) && ( he != vt->halfedge()) );
-  vt->setHalfedge(he);
+    he = he->mateRaw()->nextRaw();
+  } while ( (he->mateRaw() != nullptr) && ( he != first ) );
+  if ( he != first ) vt->setHalfedge( he->shared_from_this() );
 }
 
-inline bool isBoundary( std::shared_ptr<VertexL> vt ) {
-  VertexLCirculator vc( vt );
-  std::shared_ptr<HalfedgeL> he = vc.beginHalfedgeL();
-  do {
-    he = vc.nextHalfedgeL();
-    if ( he == nullptr ) return true;
-  } while ( he != vc.firstHalfedgeL() );
-
-  return false;
+// raw-pointer versions (see VertexLRawCirculator.hxx)
+inline bool isBoundary( const VertexL* vt ) {
+  return VertexLRawCirculator( vt ).isBoundary();
 }
 
-inline int valence( std::shared_ptr<VertexL> ovt ) {
-  int count = 0;
-  VertexLCirculator vc( ovt );
-  std::shared_ptr<VertexL> vt = vc.beginVertexL();
-  do {
-    count++;
-    vt = vc.nextVertexL();
-  } while ( (vt != vc.firstVertexL()) && (vt != nullptr) );
-
-  return count;
+inline int valence( const VertexL* vt ) {
+  return VertexLRawCirculator( vt ).num_vertices();
 }
 
-inline void calcVertexNormal( std::shared_ptr<VertexL> vt, Eigen::Vector3d& nv ) {
+inline bool isBoundary( const std::shared_ptr<VertexL>& vt ) { return isBoundary( vt.get() ); }
+inline int valence( const std::shared_ptr<VertexL>& ovt ) { return valence( ovt.get() ); }
+
+inline void calcVertexNormal( const VertexL* vt, Eigen::Vector3d& nv ) {
   nv = Eigen::Vector3d::Zero();
 
   int i = 0;
-  VertexLCirculator vc( vt );
-  std::shared_ptr<FaceL> fc = vc.beginFaceL();
-  if ( fc == nullptr ) return;
-  do {
+  for ( FaceL* fc : VertexLRawCirculator( vt ).faces() ) {
     // add face normal
     ++i;
     nv += fc->normal();
-    fc = vc.nextFaceL();
-  } while ( (fc != vc.firstFaceL()) && (fc != nullptr) );
+  }
+  if ( i == 0 ) return;
 
   // divided by its valence
   nv /= (double)i;
   nv.normalize();
 }
 
+inline void calcVertexNormal( const std::shared_ptr<VertexL>& vt, Eigen::Vector3d& nv ) {
+  calcVertexNormal( vt.get(), nv );
+}
+
 inline void printNeighborFaces(std::shared_ptr<VertexL> vt) {
   VertexLCirculator vc( vt );
   std::cout << "(nf) center vt " << vt->id() << " boundary " << isBoundary(vt) << std::endl;
@@ -115,52 +105,82 @@ inline void printNeighborVertices(std::shared_ptr<VertexL> ovt) {
   std::cout << std::endl;
 }
 
-// Next boundary halfedge when walking counter-clockwise around a chart / mesh hole.
-inline std::shared_ptr<HalfedgeL> nextBoundaryHalfedge(
-    std::shared_ptr<HalfedgeL> he) {
-  if (!he || !he->isBoundary()) return nullptr;
-  auto cur = he->next();
-  const int guard_limit = 64;
-  for (int guard = 0; guard < guard_limit; ++guard) {
-    if (!cur) return nullptr;
-    if (cur->isBoundary()) return cur;
-    auto mate = cur->mate();
-    if (!mate) return nullptr;
-    cur = mate->next();
+// Next boundary halfedge when walking counter-clockwise around a chart / mesh hole:
+// the boundary halfedge leaving he->next()->vertex(). nullptr if he is not on
+// the boundary or the fan around that vertex is broken.
+inline HalfedgeL* nextBoundaryHalfedge( HalfedgeL* he ) {
+  if ( (he == nullptr) || he->mateRaw() ) return nullptr;
+  HalfedgeL* start = he->nextRaw();
+  HalfedgeL* cur = start;
+  // mate()->next() rotates around the vertex; the guard only protects
+  // against inconsistent mates
+  const int guard_limit = 1 << 16;
+  for ( int guard = 0; guard < guard_limit; ++guard ) {
+    HalfedgeL* mate = cur->mateRaw();
+    if ( mate == nullptr ) return cur;
+    cur = mate->nextRaw();
+    if ( cur == start ) return nullptr;
   }
   return nullptr;
 }
 
+inline std::shared_ptr<HalfedgeL> nextBoundaryHalfedge(
+    const std::shared_ptr<HalfedgeL>& he) {
+  HalfedgeL* next = nextBoundaryHalfedge( he.get() );
+  return next ? next->shared_from_this() : nullptr;
+}
+
+// All boundary loops of the mesh halfedges, each as its halfedges in walking
+// order (loop[i]->vertex() are the boundary vertices).  A loop starts at its
+// first boundary halfedge in list order; a walk that breaks off (non-manifold
+// or inconsistent mates) is returned as far as it got.  Every boundary
+// halfedge is visited once; returns the number of loops.
+inline int collectBoundaryLoops(
+    const std::list<std::shared_ptr<HalfedgeL>>& halfedges,
+    std::vector<std::vector<HalfedgeL*>>& loops) {
+  loops.clear();
+  std::vector<HalfedgeL*> boundary;
+  for ( const auto& he : halfedges )
+    if ( he && he->isBoundary() ) boundary.push_back( he.get() );
+  std::unordered_map<const HalfedgeL*, int> index;
+  index.reserve( boundary.size() );
+  for ( int i = 0; i < (int) boundary.size(); ++i ) index.emplace( boundary[i], i );
+
+  std::vector<char> visited( boundary.size(), 0 );
+  for ( int i = 0; i < (int) boundary.size(); ++i ) {
+    if ( visited[i] ) continue;
+    std::vector<HalfedgeL*> loop;
+    HalfedgeL* cur = boundary[i];
+    int k = i;
+    while ( true ) {
+      visited[k] = 1;
+      loop.push_back( cur );
+      cur = nextBoundaryHalfedge( cur );
+      if ( (cur == nullptr) || (cur == boundary[i]) ) break;
+      const auto it = index.find( cur );
+      if ( (it == index.end()) || visited[it->second] ) break;
+      k = it->second;
+    }
+    loops.push_back( std::move(loop) );
+  }
+  return (int) loops.size();
+}
+
 // Collect the longest boundary loop (vertex order) from mesh halfedges.
 inline bool collectLongestBoundaryLoop(
     const std::list<std::shared_ptr<HalfedgeL>>& halfedges,
     std::vector<std::shared_ptr<VertexL>>& loop_vertices) {
   loop_vertices.clear();
-  std::set<std::shared_ptr<HalfedgeL>> visited_he;
-  std::vector<std::shared_ptr<VertexL>> best;
-
-  for (const auto& he : halfedges) {
-    if (!he || !he->isBoundary()) continue;
-    if (visited_he.count(he)) continue;
-
-    std::vector<std::shared_ptr<VertexL>> loop;
-    auto start = he;
-    auto cur = he;
-    const int guard_limit =
-        static_cast<int>(halfedges.size()) + static_cast<int>(halfedges.size()) + 8;
-    for (int guard = 0; guard < guard_limit; ++guard) {
-      if (!cur || !cur->isBoundary()) break;
-      if (visited_he.count(cur)) break;
-      visited_he.insert(cur);
-      loop.push_back(cur->vertex());
-      cur = nextBoundaryHalfedge(cur);
-      if (cur == start) break;
-    }
-    if (loop.size() > best.size()) best = std::move(loop);
-  }
+  std::vector<std::vector<HalfedgeL*>> loops;
+  collectBoundaryLoops( halfedges, loops );
+
+  const std::vector<HalfedgeL*>* best = nullptr;
+  for ( const auto& loop : loops )
+    if ( (best == nullptr) || (loop.size() > best->size()) ) best = &loop;
 
-  if (best.size() < 3) return false;
-  loop_vertices = std::move(best);
+  if ( (best == nullptr) || (best->size() < 3) ) return false;
+  loop_vertices.reserve( best->size() );
+  for ( HalfedgeL* he : *best ) loop_vertices.push_back( he->vertex() );
   return true;
 }
 
@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////
+//
+// Consistency checks of a MeshL halfedge structure.
+//
+// MeshValidatorL::validate() walks the halfedges of every face once
+// (in parallel chunks, see ParallelFor.hxx) and returns counts in a
+// MeshValidationReport: mate symmetry and orientation, next/prev
+// against the face lists, vertex->halfedge references, Euler
+// characteristic and non-manifold edges / vertices.  Nothing is
+// printed.
+//
+//   MeshValidationReport r = MeshValidatorL(mesh).validate();
+//   if (!r.isValid()) ...
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHVALIDATORL_HXX
+#define _MESHVALIDATORL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "MeshL.hxx"
+#include "ParallelFor.hxx"
+
+struct MeshValidationReport {
+
+  // sizes
+  int n_vertices = 0;
+  int n_faces = 0;
+  int n_halfedges = 0;            // halfedges listed in faces
+  int n_edges = 0;                // distinct vertex pairs of those halfedges
+  int n_boundary_edges = 0;       // edges with a single halfedge
+  int n_isolated_vertices = 0;    // vertices used by no face
+  int euler_characteristic = 0;   // V - E + F
+
+  // problems (all zero for a valid mesh)
+  int n_empty_faces = 0;
+  int n_dangling_references = 0;  // halfedge vertex / face not in the mesh
+  int n_broken_cycles = 0;        // next() / prev() disagree with the face list
+  int n_mate_errors = 0;          // mate not in a face, or mate->mate() != he
+  int n_orientation_errors = 0;   // mate does not run the opposite way
+  int n_vertex_halfedge_errors = 0;  // vertex->halfedge() missing or wrong
+
+  // non-manifold elements (allowed, but reported)
+  int n_nonmanifold_edges = 0;    // more than two halfedges
+  int n_nonmanifold_vertices = 0; // faces around a vertex form several fans
+
+  bool isValid() const {
+    return (n_empty_faces == 0) && (n_dangling_references == 0) &&
+           (n_broken_cycles == 0) && (n_mate_errors == 0) &&
+           (n_orientation_errors == 0) && (n_vertex_halfedge_errors == 0);
+  };
+  bool isManifold() const {
+    return (n_nonmanifold_edges == 0) && (n_nonmanifold_vertices == 0);
+  };
+};
+
+class MeshValidatorL {
+
+ public:
+
+  MeshValidatorL(std::shared_ptr<MeshL> mesh) : mesh_(mesh) {};
+
+  MeshValidationReport validate() const {
+    MeshValidationReport r;
+    if (!mesh_) return r;
+
+    // flat arrays of the elements
+    std::vector<VertexL*> verts;
+    verts.reserve(mesh_->vertices_size());
+    for (auto& vt : mesh_->vertices()) verts.push_back(vt.get());
+    std::vector<FaceL*> faces;
+    faces.reserve(mesh_->faces_size());
+    std::vector<HalfedgeL*> hes;
+    std::vector<int> hface;
+    std::vector<int> hnext, hprev;  // by position in the face list
+    for (auto& fc : mesh_->faces()) {
+      const int f = (int) faces.size();
+      faces.push_back(fc.get());
+      const int b = (int) hes.size();
+      for (auto& he : fc->halfedges()) {
+        hes.push_back(he.get());
+        hface.push_back(f);
+      }
+      const int e = (int) hes.size();
+      if (b == e) ++r.n_empty_faces;
+      for (int i = b; i < e; ++i) {
+        hnext.push_back((i + 1 < e) ? i + 1 : b);
+        hprev.push_back((i > b) ? i - 1 : e - 1);
+      }
+    }
+    const int nv = (int) verts.size();
+    const int nh = (int) hes.size();
+    r.n_vertices = nv;
+    r.n_faces = (int) faces.size();
+    r.n_halfedges = nh;
+
+    ElementIndex<VertexL> vindex(verts);
+    ElementIndex<FaceL> findex(faces);
+    ElementIndex<HalfedgeL> hindex(hes);
+
+    // per halfedge: vertex index, mate index (-1: none / invalid)
+    std::vector<int> hv(nh, -1), hmate(nh, -1);
+    const int nchunks = par_util::numChunks(nh, kGrain);
+    std::vector<MeshValidationReport> part(nchunks);
+    par_util::forChunks(nh, nchunks, [&](size_t b, size_t e, int c) {
+      MeshValidationReport& p = part[c];
+      for (size_t i = b; i < e; ++i) {
+        HalfedgeL* he = hes[i];
+        const int v = he->vertexRaw() ? vindex.find(he->vertexRaw()) : -1;
+        hv[i] = v;
+        const bool own_face = (he->faceRaw() == faces[hface[i]]);
+        if ((v < 0) || !own_face || (findex.find(he->faceRaw()) < 0)) {
+          ++p.n_dangling_references;
+        }
+        // next/prev follow the face list (only valid for the own face)
+        if (!own_face || (he->nextRaw() != hes[hnext[i]]) ||
+            (he->prevRaw() != hes[hprev[i]])) {
+          ++p.n_broken_cycles;
+        }
+        if (he->mateRaw()) {
+          const int m = hindex.find(he->mateRaw());
+          if ((m < 0) || (hes[m]->mateRaw() != he)) {
+            ++p.n_mate_errors;
+          } else {
+            hmate[i] = m;
+          }
+        }
+      }
+    });
+    // orientation needs the vertices of both sides
+    par_util::forChunks(nh, nchunks, [&](size_t b, size_t e, int c) {
+      MeshValidationReport& p = part[c];
+      for (size_t i = b; i < e; ++i) {
+        const int m = hmate[i];
+        if (m < 0) continue;
+        if ((hv[m] != hv[hnext[i]]) || (hv[hnext[m]] != hv[i])) {
+          ++p.n_orientation_errors;
+          hmate[i] = -1;
+        }
+      }
+    });
+    for (auto& p : part) {
+      r.n_dangling_references += p.n_dangling_references;
+      r.n_broken_cycles += p.n_broken_cycles;
+      r.n_mate_errors += p.n_mate_errors;
+      r.n_orientation_errors += p.n_orientation_errors;
+    }
+
+    // vertex -> halfedge
+    std::vector<char> used(nv, 0);
+    for (int i = 0; i < nh; ++i)
+      if (hv[i] >= 0) used[hv[i]] = 1;
+    const int vchunks = par_util::numChunks(nv, kGrain);
+    std::vector<int> vpart(vchunks, 0), ipart(vchunks, 0);
+    par_util::forChunks(nv, vchunks, [&](size_t b, size_t e, int c) {
+      for (size_t v = b; v < e; ++v) {
+        if (!used[v]) ++ipart[c];
+        HalfedgeL* he = verts[v]->halfedgeRaw();
+        if (he == nullptr) {
+          if (used[v]) ++vpart[c];
+          continue;
+        }
+        if ((hindex.find(he) < 0) || (he->vertexRaw() != verts[v])) ++vpart[c];
+      }
+    });
+    r.n_vertex_halfedge_errors = std::accumulate(vpart.begin(), vpart.end(), 0);
+    r.n_isolated_vertices = std::accumulate(ipart.begin(), ipart.end(), 0);
+
+    // edges: halfedges sorted by (min, max) vertex
+    std::vector<std::pair<uint64_t, int> > keys;
+    keys.reserve(nh);
+    for (int i = 0; i < nh; ++i) {
+      const int a = hv[i], b = hv[hnext[i]];
+      if ((a < 0) || (b < 0)) continue;
+      const uint64_t lo = (uint64_t) std::min(a, b), hi = (uint64_t) std::max(a, b);
+      keys.push_back(std::make_pair((lo << 32) | hi, i));
+    }
+    par_util::parallelSort(keys, [](const std::pair<uint64_t, int>& x,
+                                    const std::pair<uint64_t, int>& y) {
+      return x.first < y.first;
+    });
+    for (size_t i = 0; i < keys.size();) {
+      size_t j = i + 1;
+      while ((j < keys.size()) && (keys[j].first == keys[i].first)) ++j;
+      ++r.n_edges;
+      if (j - i == 1) ++r.n_boundary_edges;
+      if (j - i > 2) ++r.n_nonmanifold_edges;
+      i = j;
+    }
+    r.euler_characteristic = r.n_vertices - r.n_edges + r.n_faces;
+
+    // vertex fans: the corner of he at its vertex is joined with the
+    // corner of mate(prev(he)) at the same vertex
+    std::vector<int> root(nh);
+    std::iota(root.begin(), root.end(), 0);
+    for (int i = 0; i < nh; ++i) {
+      const int m = hmate[hprev[i]];
+      if ((m >= 0) && (hv[m] == hv[i])) unite(root, i, m);
+    }
+    std::vector<std::pair<int, int> > fans;
+    fans.reserve(nh);
+    for (int i = 0; i < nh; ++i)
+      if (hv[i] >= 0) fans.push_back(std::make_pair(hv[i], findRoot(root, i)));
+    par_util::parallelSort(fans, std::less<std::pair<int, int> >());
+    fans.erase(std::unique(fans.begin(), fans.end()), fans.end());
+    for (size_t i = 1; i < fans.size(); ++i)
+      if ((fans[i].first == fans[i - 1].first) &&
+          ((i < 2) || (fans[i - 2].first != fans[i].first)))
+        ++r.n_nonmanifold_vertices;
+
+    return r;
+  };
+
+ private:
+
+  static constexpr size_t kGrain = 1 << 14;
+
+  std::shared_ptr<MeshL> mesh_;
+
+  // element -> position in a flat array; by id while ids are unique
+  template <class T>
+  class ElementIndex {
+   public:
+    explicit ElementIndex(const std::vector<T*>& elems) : elems_(elems) {
+      int max_id = -1;
+      for (T* e : elems) max_id = std::max(max_id, e->id());
+      bool unique = true;
+      if (max_id >= 0) {
+        table_.assign(max_id + 1, -1);
+        for (int i = 0; i < (int) elems.size(); ++i) {
+          const int id = elems[i]->id();
+          if ((id < 0) || (table_[id] >= 0)) {
+            unique = false;
+            break;
+          }
+          table_[id] = i;
+        }
+      }
+      if (!unique) {
+        table_.clear();
+        map_.reserve(elems.size());
+        for (int i = 0; i < (int) elems.size(); ++i) map_.emplace(elems[i], i);
+      }
+    };
+
+    // -1 if e is not in the array
+    int find(const T* e) const {
+      if (e == nullptr) return -1;
+      if (!map_.empty()) {
+        auto it = map_.find(e);
+        return (it == map_.end()) ? -1 : it->second;
+      }
+      const int id = e->id();
+      if ((id < 0) || (id >= (int) table_.size())) return -1;
+      const int i = table_[id];
+      return ((i >= 0) && (elems_[i] == e)) ? i : -1;
+    };
+
+   private:
+    const std::vector<T*>& elems_;
+    std::vector<int> table_;
+    std::unordered_map<const T*, int> map_;
+  };
+
+  static int findRoot(std::vector<int>& root, int i) {
+    while (root[i] != i) {
+      root[i] = root[root[i]];
+      i = root[i];
+    }
+    return i;
+  };
+
+  static void unite(std::vector<int>& root, int a, int b) {
+    a = findRoot(root, a);
+    b = findRoot(root, b);
+    if (a != b) root[std::max(a, b)] = std::min(a, b);
+  };
+};
+
+#endif // _MESHVALIDATORL_HXX
@@ -0,0 +1,254 @@
+////////////////////////////////////////////////////////////////////
+//
+// Allocation-free tokenizer for OBJ/SMF text (used by SMFLIO).
+//
+// The file is read in one block and split into newline-aligned
+// ranges that are parsed independently (in parallel) into ObjChunkL
+// records with std::from_chars; no std::string or stream is created
+// per line.  The records keep the file order so that they can be
+// applied to a MeshL sequentially with the semantics of the former
+// line-by-line parser:
+//
+//   v x y z [r g b]     vn / n x y z      vt / r u v [w]
+//   f v  v/vt  v//vn  v/vt/vn  (v/n when only normals exist)
+//   b [-]v ...          (negative: not a corner)
+//
+// Lines whose first character is one of '!', '%', '#', '*' are
+// comments.
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _OBJPARSERL_HXX
+#define _OBJPARSERL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+// records of a range of lines, in file order
+struct ObjChunkL {
+
+  enum Kind : uint8_t { VERTEX = 0, NORMAL, TEXCOORD, FACE, BLOOP };
+
+  // face corner: v/t/n indices as written (kNone: field empty or invalid)
+  static constexpr int kNone = std::numeric_limits<int>::min();
+  struct Corner {
+    int v, t, n;
+    uint8_t nparts;  // number of '/' separated fields (1..3)
+  };
+
+  std::vector<uint8_t> kinds;
+  std::vector<double> values;    // v: x y z [r g b], vn: x y z, vt: u v w
+  std::vector<uint8_t> colored;  // per v: r g b follow
+  std::vector<Corner> corners;
+  std::vector<int> face_sizes;   // corners per f
+  std::vector<int> bloop;        // indices of b lines
+  std::vector<int> bloop_sizes;
+
+  void clear() {
+    kinds.clear();
+    values.clear();
+    colored.clear();
+    corners.clear();
+    face_sizes.clear();
+    bloop.clear();
+    bloop_sizes.clear();
+  };
+};
+
+class ObjParserL {
+
+ public:
+
+  // whole file into buf
+  static bool readFile(const char* const filename, std::string& buf) {
+    FILE* fp = fopen(filename, "rb");
+    if (fp == nullptr) return false;
+    buf.clear();
+    if (fseek(fp, 0, SEEK_END) == 0) {
+      const long size = ftell(fp);
+      if (size > 0) buf.resize((size_t) size);
+      fseek(fp, 0, SEEK_SET);
+    }
+    size_t n = buf.empty() ? 0 : fread(&buf[0], 1, buf.size(), fp);
+    buf.resize(n);
+    // size unknown (pipes etc.)
+    char tmp[1 << 16];
+    size_t m;
+    while ((m = fread(tmp, 1, sizeof(tmp), fp)) > 0) buf.append(tmp, m);
+    fclose(fp);
+    return true;
+  };
+
+  // [begin, end) offsets of about n ranges, each ending after a newline
+  static std::vector<std::pair<size_t, size_t> > splitLines(const char* data, size_t size, int n) {
+    std::vector<std::pair<size_t, size_t> > ranges;
+    if (n < 1) n = 1;
+    size_t b = 0;
+    for (int c = 1; (c <= n) && (b < size); ++c) {
+      size_t e = (c == n) ? size : std::max(b, size * c / n);
+      if (e < size) {
+        const void* nl = memchr(data + e, '\n', size - e);
+        e = nl ? (size_t) ((const char*) nl - data) + 1 : size;
+      }
+      if (e > b) ranges.push_back(std::make_pair(b, e));
+      b = e;
+    }
+    return ranges;
+  };
+
+  // lines in [b, e) appended to out
+  static void parse(const char* b, const char* e, ObjChunkL& out) {
+    while (b < e) {
+      const char* nl = (const char*) memchr(b, '\n', e - b);
+      const char* le = nl ? nl : e;
+      parseLine(b, le, out);
+      b = nl ? nl + 1 : e;
+    }
+  };
+
+  static void parseLine(const char* b, const char* e, ObjChunkL& out) {
+    if (b == e) return;
+    if (isComment(*b)) return;
+    Cursor cur(b, e);
+    const char* wb;
+    const char* we;
+    if (!cur.word(wb, we)) return;
+    const size_t wn = we - wb;
+
+    if ((wn == 1) && (*wb == 'v')) {
+      double x[6] = {0, 0, 0, 0, 0, 0};
+      cur.number(x[0]) && cur.number(x[1]) && cur.number(x[2]);
+      const bool color = cur.number(x[3]);
+      if (color) cur.number(x[4]) && cur.number(x[5]);
+      out.kinds.push_back(ObjChunkL::VERTEX);
+      out.values.insert(out.values.end(), x, x + (color ? 6 : 3));
+      out.colored.push_back(color ? 1 : 0);
+    } else if (((wn == 2) && (wb[0] == 'v') && (wb[1] == 'n')) || ((wn == 1) && (*wb == 'n'))) {
+      double x[3] = {0, 0, 0};
+      cur.number(x[0]) && cur.number(x[1]) && cur.number(x[2]);
+      out.kinds.push_back(ObjChunkL::NORMAL);
+      out.values.insert(out.values.end(), x, x + 3);
+    } else if (((wn == 2) && (wb[0] == 'v') && (wb[1] == 't')) || ((wn == 1) && (*wb == 'r'))) {
+      double x[3] = {0, 0, 0};
+      cur.number(x[0]) && cur.number(x[1]) && cur.number(x[2]);
+      out.kinds.push_back(ObjChunkL::TEXCOORD);
+      out.values.insert(out.values.end(), x, x + 3);
+    } else if ((wn == 1) && (*wb == 'f')) {
+      int count = 0;
+      const char* tb;
+      const char* te;
+      while (cur.word(tb, te)) {
+        // fields separated by '/', empty ones kept ("1//2")
+        const char* fb[3] = {tb, nullptr, nullptr};
+        const char* fe[3] = {te, te, te};
+        int nparts = 1;
+        for (const char* p = tb; p < te; ++p) {
+          if (*p != '/') continue;
+          if (nparts <= 3) fe[nparts - 1] = p;
+          if (nparts < 3) fb[nparts] = p + 1;
+          ++nparts;
+        }
+        ObjChunkL::Corner c;
+        if (!toInt(fb[0], fe[0], c.v)) continue;
+        c.t = ((nparts >= 2) && toInt(fb[1], fe[1], c.t)) ? c.t : ObjChunkL::kNone;
+        c.n = ((nparts >= 3) && toInt(fb[2], fe[2], c.n)) ? c.n : ObjChunkL::kNone;
+        c.nparts = (uint8_t) std::min(nparts, 3);
+        out.corners.push_back(c);
+        ++count;
+      }
+      out.kinds.push_back(ObjChunkL::FACE);
+      out.face_sizes.push_back(count);
+    } else if ((wn == 1) && (*wb == 'b')) {
+      int count = 0;
+      int id;
+      while (cur.integer(id)) {
+        out.bloop.push_back(id);
+        ++count;
+      }
+      out.kinds.push_back(ObjChunkL::BLOOP);
+      out.bloop_sizes.push_back(count);
+    }
+  };
+
+  static bool isComment(char c) {
+    return (c == '\n') || (c == '!') || (c == '%') || (c == '#') || (c == '*');
+  };
+
+  static bool isSpace(char c) {
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+  };
+
+  // leading integer of [b, e) (as operator>> reads it)
+  static bool toInt(const char* b, const char* e, int& v) {
+    if ((b < e) && (*b == '+') && (b + 1 < e) && (b[1] != '-')) ++b;
+    if (b >= e) return false;
+    auto r = std::from_chars(b, e, v);
+    return r.ec == std::errc();
+  };
+
+  // whitespace separated reads on a line; once a read fails all
+  // following ones fail too (as with a std::istream)
+  class Cursor {
+   public:
+    Cursor(const char* b, const char* e) : p_(b), e_(e) {};
+
+    bool word(const char*& wb, const char*& we) {
+      if (fail_ || !skip()) return false;
+      wb = p_;
+      while ((p_ < e_) && !isSpace(*p_)) ++p_;
+      we = p_;
+      return true;
+    };
+
+    bool number(double& v) {
+      if (fail_ || !skip()) return fail();
+      const char* b = p_;
+      if ((*b == '+') && (b + 1 < e_) && (b[1] != '-')) ++b;
+      auto r = std::from_chars(b, e_, v);
+      if (r.ec != std::errc()) {
+        v = 0.0;
+        return fail();
+      }
+      p_ = r.ptr;
+      return true;
+    };
+
+    bool integer(int& v) {
+      if (fail_ || !skip()) return fail();
+      const char* b = p_;
+      if ((*b == '+') && (b + 1 < e_) && (b[1] != '-')) ++b;
+      auto r = std::from_chars(b, e_, v);
+      if (r.ec != std::errc()) return fail();
+      p_ = r.ptr;
+      return true;
+    };
+
+   private:
+    const char* p_;
+    const char* e_;
+    bool fail_ = false;
+
+    bool skip() {
+      while ((p_ < e_) && isSpace(*p_)) ++p_;
+      return p_ < e_;
+    };
+    bool fail() {
+      fail_ = true;
+      return false;
+    };
+  };
+};
+
+#endif // _OBJPARSERL_HXX
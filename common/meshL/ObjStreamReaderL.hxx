@@ -0,0 +1,283 @@
+////////////////////////////////////////////////////////////////////
+//
+// Streaming OBJ/SMF reader: delivers the file in blocks of bounded
+// size without building a MeshL, so statistics, bounding boxes,
+// spatial binning or format conversion run in constant memory on files
+// larger than RAM.
+//
+// The file is read blockBytes at a time (cut after the last newline),
+// each block is tokenized in parallel with ObjParserL and decoded into
+// an ObjStreamBlockL with the index rules of SMFLIO::inputFromFile.
+// Indices are 0-based and global over the whole file; a face may
+// refer to vertices of earlier blocks.
+//
+//   ObjStreamReaderL reader;
+//   reader.open("scan.obj");
+//   ObjStreamBlockL block;
+//   while (reader.next(block)) { ... }             // pull
+//
+//   ObjStreamReaderL::forEach("scan.obj",           // callback
+//                             [](const ObjStreamBlockL& b) { ... });
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _OBJSTREAMREADERL_HXX
+#define _OBJSTREAMREADERL_HXX 1
+
+#include "envDep.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ObjParserL.hxx"
+#include "ParallelFor.hxx"
+
+// records of one block
+struct ObjStreamBlockL {
+
+  // global indices of the first vertex / normal / texcoord / face /
+  // boundary loop of this block
+  size_t first_vertex = 0;
+  size_t first_normal = 0;
+  size_t first_texcoord = 0;
+  size_t first_face = 0;
+  size_t first_bloop = 0;
+
+  std::vector<double> points;     // x y z per vertex
+  std::vector<uint8_t> has_color; // per vertex
+  std::vector<double> colors;     // r g b per vertex (0 when no color)
+  std::vector<double> normals;    // x y z per normal
+  std::vector<double> texcoords;  // u v w per texcoord
+
+  // corners of face f: [face_offset[f], face_offset[f + 1]), -1: none
+  std::vector<size_t> face_offset = {0};
+  std::vector<int64_t> face_vertex;
+  std::vector<int64_t> face_texcoord;
+  std::vector<int64_t> face_normal;
+
+  // vertices of boundary loop b: [bloop_offset[b], bloop_offset[b + 1])
+  std::vector<size_t> bloop_offset = {0};
+  std::vector<int64_t> bloop_vertex;
+  std::vector<uint8_t> bloop_corner;
+
+  size_t numVertices() const { return has_color.size(); };
+  size_t numNormals() const { return normals.size() / 3; };
+  size_t numTexcoords() const { return texcoords.size() / 3; };
+  size_t numFaces() const { return face_offset.size() - 1; };
+  size_t numBLoops() const { return bloop_offset.size() - 1; };
+
+  void clear() {
+    points.clear();
+    has_color.clear();
+    colors.clear();
+    normals.clear();
+    texcoords.clear();
+    face_offset.assign(1, 0);
+    face_vertex.clear();
+    face_texcoord.clear();
+    face_normal.clear();
+    bloop_offset.assign(1, 0);
+    bloop_vertex.clear();
+    bloop_corner.clear();
+  };
+};
+
+class ObjStreamReaderL {
+
+ public:
+
+  explicit ObjStreamReaderL(size_t blockBytes = 32 << 20) : block_bytes_(blockBytes) {
+    if (block_bytes_ < 4096) block_bytes_ = 4096;
+  };
+  ~ObjStreamReaderL() { close(); };
+
+  ObjStreamReaderL(const ObjStreamReaderL&) = delete;
+  ObjStreamReaderL& operator=(const ObjStreamReaderL&) = delete;
+
+  bool open(const char* const filename) {
+    close();
+    fp_ = fopen(filename, "rb");
+    if (fp_ == nullptr) {
+      std::cerr << "Cannot open " << filename << std::endl;
+      return false;
+    }
+    buf_.clear();
+    nv_ = nn_ = nt_ = nf_ = nb_ = 0;
+    eof_ = false;
+    return true;
+  };
+
+  void close() {
+    if (fp_) fclose(fp_);
+    fp_ = nullptr;
+  };
+
+  // next block; false at the end of the file
+  bool next(ObjStreamBlockL& block) {
+    block.clear();
+    if (fp_ == nullptr) return false;
+    while (true) {
+      const size_t cut = fill();
+      if (cut == 0) {
+        close();
+        return false;
+      }
+      decode(cut, block);
+      buf_.erase(0, cut);
+      // skip blocks of comments only
+      if (block.numVertices() || block.numNormals() || block.numTexcoords() ||
+          block.numFaces() || block.numBLoops())
+        return true;
+    }
+  };
+
+  // f(const ObjStreamBlockL&) for each block
+  template <class F>
+  static bool forEach(const char* const filename, F f, size_t blockBytes = 32 << 20) {
+    ObjStreamReaderL reader(blockBytes);
+    if (!reader.open(filename)) return false;
+    ObjStreamBlockL block;
+    while (reader.next(block)) f(static_cast<const ObjStreamBlockL&>(block));
+    return true;
+  };
+
+  // totals over the blocks read so far
+  size_t numVertices() const { return nv_; };
+  size_t numNormals() const { return nn_; };
+  size_t numTexcoords() const { return nt_; };
+  size_t numFaces() const { return nf_; };
+  size_t numBLoops() const { return nb_; };
+
+ private:
+
+  size_t block_bytes_;
+  FILE* fp_ = nullptr;
+  bool eof_ = false;
+  std::string buf_;
+  std::vector<ObjChunkL> chunks_;
+  size_t nv_ = 0, nn_ = 0, nt_ = 0, nf_ = 0, nb_ = 0;
+
+  // reads up to about block_bytes_ and returns the length of the
+  // leading part of buf_ that ends with a newline (or the rest at EOF)
+  size_t fill() {
+    while (true) {
+      if (!eof_ && (buf_.size() < block_bytes_)) {
+        const size_t old = buf_.size();
+        buf_.resize(block_bytes_);
+        const size_t n = fread(&buf_[old], 1, block_bytes_ - old, fp_);
+        buf_.resize(old + n);
+        if (n < block_bytes_ - old) eof_ = true;
+      }
+      if (eof_) return buf_.size();
+      for (size_t i = buf_.size(); i > 0; --i)
+        if (buf_[i - 1] == '\n') return i;
+      // a line longer than the block
+      block_bytes_ *= 2;
+    }
+  };
+
+  void decode(size_t size, ObjStreamBlockL& block) {
+    const char* data = buf_.data();
+    const int nchunks = par_util::numChunks(size, 1 << 20);
+    auto ranges = ObjParserL::splitLines(data, size, nchunks);
+    chunks_.resize(ranges.size());
+    par_util::forChunks(ranges.size(), (int) ranges.size(), [&](size_t b, size_t e, int) {
+      for (size_t c = b; c < e; ++c) {
+        chunks_[c].clear();
+        ObjParserL::parse(data + ranges[c].first, data + ranges[c].second, chunks_[c]);
+      }
+    });
+
+    block.first_vertex = nv_;
+    block.first_normal = nn_;
+    block.first_texcoord = nt_;
+    block.first_face = nf_;
+    block.first_bloop = nb_;
+    for (size_t c = 0; c < ranges.size(); ++c) decodeChunk(chunks_[c], block);
+  };
+
+  // same index rules as SMFLIO::inputFromFile (invalid indices dropped)
+  void decodeChunk(const ObjChunkL& ch, ObjStreamBlockL& block) {
+    size_t iv = 0, ic = 0, icorner = 0, iface = 0, ib = 0, ibloop = 0;
+    for (uint8_t kind : ch.kinds) {
+      switch (kind) {
+        case ObjChunkL::VERTEX: {
+          const double* x = &ch.values[iv];
+          block.points.insert(block.points.end(), x, x + 3);
+          const bool color = ch.colored[ic++] != 0;
+          block.has_color.push_back(color ? 1 : 0);
+          if (color) {
+            block.colors.insert(block.colors.end(), x + 3, x + 6);
+            iv += 3;
+          } else {
+            block.colors.insert(block.colors.end(), 3, 0.0);
+          }
+          iv += 3;
+          ++nv_;
+          break;
+        }
+        case ObjChunkL::NORMAL:
+          block.normals.insert(block.normals.end(), &ch.values[iv], &ch.values[iv] + 3);
+          iv += 3;
+          ++nn_;
+          break;
+        case ObjChunkL::TEXCOORD:
+          block.texcoords.insert(block.texcoords.end(), &ch.values[iv], &ch.values[iv] + 3);
+          iv += 3;
+          ++nt_;
+          break;
+        case ObjChunkL::FACE: {
+          const int n = ch.face_sizes[iface++];
+          for (int i = 0; i < n; ++i) {
+            const ObjChunkL::Corner& c = ch.corners[icorner++];
+            if (!inRange(c.v, nv_)) continue;
+            int64_t t = -1, nm = -1;
+            if (c.nparts == 2) {
+              // f v/vt  or legacy f v/n (when only normals exist)
+              if (nt_) {
+                if (inRange(c.t, nt_)) t = c.t - 1;
+              } else if (nn_) {
+                if (inRange(c.t, nn_)) nm = c.t - 1;
+              }
+            } else if (c.nparts >= 3) {
+              if (nt_ && inRange(c.t, nt_)) t = c.t - 1;
+              if (nn_ && inRange(c.n, nn_)) nm = c.n - 1;
+            }
+            block.face_vertex.push_back(c.v - 1);
+            block.face_texcoord.push_back(t);
+            block.face_normal.push_back(nm);
+          }
+          block.face_offset.push_back(block.face_vertex.size());
+          ++nf_;
+          break;
+        }
+        case ObjChunkL::BLOOP: {
+          const int n = ch.bloop_sizes[ibloop++];
+          for (int i = 0; i < n; ++i) {
+            int id = ch.bloop[ib++];
+            const bool is_corner = (id > 0);
+            if (!is_corner) id *= -1;  // reverse
+            if (!inRange(id, nv_)) continue;
+            block.bloop_vertex.push_back(id - 1);
+            block.bloop_corner.push_back(is_corner ? 1 : 0);
+          }
+          block.bloop_offset.push_back(block.bloop_vertex.size());
+          ++nb_;
+          break;
+        }
+      }
+    }
+  };
+
+  // 1-based id (kNone never matches)
+  static bool inRange(int id, size_t n) { return (id >= 1) && ((size_t) id <= n); };
+};
+
+#endif // _OBJSTREAMREADERL_HXX
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////
+//
+// Text formatting for OBJ/SMF output (used by SMFLIO).
+//
+// Numbers are written with std::to_chars into std::string buffers;
+// a double is formatted as std::ostream does by default (%g with
+// precision 6) and an int as in decimal, so the output is identical to
+// the former stream-based writer.  Sections are formatted in parallel
+// chunks which are concatenated in order for a single write.
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _OBJWRITERL_HXX
+#define _OBJWRITERL_HXX 1
+
+#include "envDep.h"
+
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ParallelFor.hxx"
+
+class ObjWriterL {
+
+ public:
+
+  static void put(std::string& out, double v) {
+    char tmp[32];
+    auto r = std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::general, 6);
+    out.append(tmp, r.ptr - tmp);
+  };
+
+  static void put(std::string& out, int v) {
+    char tmp[16];
+    auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    out.append(tmp, r.ptr - tmp);
+  };
+
+  static void put(std::string& out, const char* s) { out.append(s, strlen(s)); };
+  static void put(std::string& out, char c) { out.push_back(c); };
+
+  // "x y z" of a 3-vector
+  template <class V>
+  static void put3(std::string& out, const V& p) {
+    put(out, p.x());
+    put(out, ' ');
+    put(out, p.y());
+    put(out, ' ');
+    put(out, p.z());
+  };
+
+  // f(i, out) for i in [0, n) appended to out in order; chunks of
+  // about grain items are formatted in parallel
+  template <class F>
+  static void format(size_t n, std::string& out, F f, size_t grain = 1 << 14) {
+    const int nchunks = par_util::numChunks(n, grain);
+    if (nchunks <= 1) {
+      for (size_t i = 0; i < n; ++i) f(i, out);
+      return;
+    }
+    std::vector<std::string> bufs(nchunks);
+    par_util::forChunks(n, nchunks, [&](size_t b, size_t e, int c) {
+      bufs[c].reserve((e - b) * 40);
+      for (size_t i = b; i < e; ++i) f(i, bufs[c]);
+    });
+    size_t size = out.size();
+    for (auto& s : bufs) size += s.size();
+    out.reserve(size);
+    for (auto& s : bufs) out += s;
+  };
+};
+
+#endif // _OBJWRITERL_HXX
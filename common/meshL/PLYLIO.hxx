@@ -0,0 +1,621 @@
+////////////////////////////////////////////////////////////////////
+//
+// PLY input / output for MeshL (ASCII, binary little / big endian).
+//
+// Reading: the whole file is read at once; vertex records of fixed
+// size are decoded in parallel straight from the buffer (with byte
+// swapping for the other endianness), other records sequentially with
+// memcpy (binary) or std::from_chars (ASCII).  Recognized properties:
+//
+//   vertex  x y z (float / double / integer types)
+//           nx ny nz                         -> one NormalL per vertex
+//           s t | u v | texture_u texture_v  -> one TexcoordL per vertex
+//           red green blue                   -> VertexL::setColor
+//                                               (uchar / ushort scaled to [0, 1])
+//   face    vertex_indices | vertex_index (list)
+//
+// Other properties and elements are skipped.
+//
+// Writing: binary little endian by default (setFormat), float
+// positions (setSaveDouble for double).  Normals, texcoords and colors
+// follow isSaveNormal / isSaveTexcoord / isSaveColor; normals and
+// texcoords are written per vertex and only when each vertex has a
+// single one.  Normalized meshes are stored in their original scale.
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _PLYLIO_HXX
+#define _PLYLIO_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LIO.hxx"
+#include "ObjParserL.hxx"
+#include "ParallelFor.hxx"
+#include "myEigen.hxx"
+
+class PLYLIO : public LIO {
+
+ public:
+
+  enum Format { ASCII = 0, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+
+  PLYLIO() : LIO() {};
+  PLYLIO(MeshL& mesh) : LIO(mesh) {};
+  ~PLYLIO() {};
+
+  // output format (input detects it from the header)
+  void setFormat(Format f) { format_ = f; };
+  Format format() const { return format_; };
+  void setSaveDouble(bool f) { isSaveDouble_ = f; };
+  bool isSaveDouble() const { return isSaveDouble_; };
+
+  bool inputFromFile(const char* const filename) {
+    std::string buf;
+    if (!ObjParserL::readFile(filename, buf)) {
+      std::cerr << "Cannot open " << filename << std::endl;
+      return false;
+    }
+    std::vector<Element> elements;
+    Format format;
+    size_t body = 0;
+    if (!readHeader(buf, format, elements, body)) {
+      std::cerr << "Not a PLY file: " << filename << std::endl;
+      return false;
+    }
+
+    Body in(buf.data() + body, buf.data() + buf.size(), format);
+    VertexData vd;
+    std::vector<size_t> face_offset(1, 0);
+    std::vector<int64_t> face_index;
+    for (auto& el : elements) {
+      bool ok;
+      if (el.name == "vertex") ok = readVertices(el, in, vd);
+      else if (el.name == "face") ok = readFaces(el, in, face_offset, face_index);
+      else ok = skip(el, in);
+      if (!ok) {
+        std::cerr << "Broken PLY file (element " << el.name << "): " << filename << std::endl;
+        return false;
+      }
+    }
+
+    //
+    // build the mesh
+    //
+    const size_t nv = vd.points.size() / 3;
+    const size_t nf = face_offset.size() - 1;
+    mesh().reserve((int) nv, (int) nf, (int) face_index.size(),
+                   vd.has_texcoord ? (int) nv : 0, vd.has_normal ? (int) nv : 0);
+    std::vector<std::shared_ptr<VertexL> > vts(nv);
+    std::vector<std::shared_ptr<NormalL> > nms(vd.has_normal ? nv : 0);
+    std::vector<std::shared_ptr<TexcoordL> > tcs(vd.has_texcoord ? nv : 0);
+    for (size_t i = 0; i < nv; ++i) {
+      Eigen::Vector3d p(vd.points[3 * i], vd.points[3 * i + 1], vd.points[3 * i + 2]);
+      vts[i] = mesh().addVertex(p);
+      if (vd.has_color)
+        vts[i]->setColor(vd.colors[3 * i], vd.colors[3 * i + 1], vd.colors[3 * i + 2]);
+    }
+    for (size_t i = 0; i < nms.size(); ++i) {
+      Eigen::Vector3d p(vd.normals[3 * i], vd.normals[3 * i + 1], vd.normals[3 * i + 2]);
+      nms[i] = mesh().addNormal(p);
+    }
+    for (size_t i = 0; i < tcs.size(); ++i) {
+      Eigen::Vector3d p(vd.texcoords[2 * i], vd.texcoords[2 * i + 1], 0.0);
+      tcs[i] = mesh().addTexcoord(p);
+    }
+
+    std::vector<FaceL*> faces(nf);
+    for (size_t f = 0; f < nf; ++f) {
+      std::shared_ptr<FaceL> fc = mesh().addFace();
+      for (size_t i = face_offset[f]; i < face_offset[f + 1]; ++i) {
+        const int64_t v = face_index[i];
+        if ((v < 0) || ((size_t) v >= nv)) continue;
+        mesh().addHalfedge(fc, vts[v], nms.empty() ? nullptr : nms[v],
+                           tcs.empty() ? nullptr : tcs[v]);
+      }
+      faces[f] = fc.get();
+    }
+    par_util::parallelFor(0, faces.size(), [&](size_t i) {
+      if (faces[i]->size() >= 3) faces[i]->calcNormal();
+    });
+
+    mesh().printInfo();
+
+    return true;
+  };
+
+  bool outputToFile(const char* const filename) {
+    mesh().printInfo();
+
+    // per-vertex attributes
+    std::unordered_map<const VertexL*, size_t> vmap;
+    std::vector<VertexL*> vts;
+    vmap.reserve(mesh().vertices_size());
+    bool has_color = false;
+    for (auto& vt : mesh().vertices()) {
+      vmap[vt.get()] = vts.size();
+      vts.push_back(vt.get());
+      has_color = has_color || vt->hasColor();
+    }
+    has_color = has_color && isSaveColor();
+    std::vector<NormalL*> vnormal(isSaveNormal() ? vts.size() : 0, nullptr);
+    std::vector<TexcoordL*> vtexcoord(isSaveTexcoord() ? vts.size() : 0, nullptr);
+    bool has_normal = isSaveNormal() && !mesh().normals().empty();
+    bool has_texcoord = isSaveTexcoord() && !mesh().texcoords().empty();
+
+    std::vector<uint32_t> face_size;
+    std::vector<uint32_t> face_index;
+    face_size.reserve(mesh().faces_size());
+    for (auto& fc : mesh().faces()) {
+      face_size.push_back((uint32_t) fc->halfedges().size());
+      for (auto& he : fc->halfedges()) {
+        auto it = vmap.find(he->vertexRaw());
+        if (it == vmap.end()) {
+          std::cerr << "Halfedge vertex not in the mesh" << std::endl;
+          return false;
+        }
+        const size_t v = it->second;
+        face_index.push_back((uint32_t) v);
+        if (has_normal) has_normal = assign(vnormal[v], he->normalRaw());
+        if (has_texcoord) has_texcoord = assign(vtexcoord[v], he->texcoordRaw());
+      }
+    }
+    if (isSaveNormal() && !mesh().normals().empty() && !has_normal)
+      std::cerr << "PLY: normals are not per vertex, not saved" << std::endl;
+    if (isSaveTexcoord() && !mesh().texcoords().empty() && !has_texcoord)
+      std::cerr << "PLY: texcoords are not per vertex, not saved" << std::endl;
+    const uint32_t max_face = face_size.empty() ? 0 : *std::max_element(face_size.begin(), face_size.end());
+
+    //
+    // header
+    //
+    const char* real = isSaveDouble() ? "double" : "float";
+    std::ostringstream hs;
+    hs << "ply\n";
+    hs << "format " << formatName(format()) << " 1.0\n";
+    hs << "comment Generated by PLYLIO\n";
+    hs << "element vertex " << vts.size() << "\n";
+    hs << "property " << real << " x\nproperty " << real << " y\nproperty " << real << " z\n";
+    if (has_normal) hs << "property float nx\nproperty float ny\nproperty float nz\n";
+    if (has_texcoord) hs << "property float s\nproperty float t\n";
+    if (has_color) hs << "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+    hs << "element face " << face_size.size() << "\n";
+    hs << "property list " << ((max_face > 255) ? "int" : "uchar") << " int vertex_indices\n";
+    hs << "end_header\n";
+
+    //
+    // body
+    //
+    std::string out = hs.str();
+    Out o(out, format());
+    const bool norm = mesh().isNormalized();
+    const double len = mesh().maxLength();
+    const Eigen::Vector3d center = mesh().center();
+    static const Eigen::Vector3d zero(0.0, 0.0, 0.0);
+    for (size_t i = 0; i < vts.size(); ++i) {
+      Eigen::Vector3d p = vts[i]->point();
+      if (norm) p = p * len + center;
+      for (int k = 0; k < 3; ++k) {
+        if (isSaveDouble()) o.put(p[k]);
+        else o.put((float) p[k]);
+      }
+      if (has_normal) {
+        const Eigen::Vector3d& n = vnormal[i] ? vnormal[i]->point() : zero;
+        o.put((float) n.x()); o.put((float) n.y()); o.put((float) n.z());
+      }
+      if (has_texcoord) {
+        const Eigen::Vector3d& t = vtexcoord[i] ? vtexcoord[i]->point() : zero;
+        o.put((float) t.x()); o.put((float) t.y());
+      }
+      if (has_color) {
+        const Eigen::Vector3d& c = vts[i]->color();
+        for (int k = 0; k < 3; ++k)
+          o.put((uint8_t) std::min(255.0, std::max(0.0, c[k] * 255.0 + 0.5)));
+      }
+      o.end();
+    }
+    size_t j = 0;
+    for (uint32_t n : face_size) {
+      if (max_face > 255) o.put((int32_t) n);
+      else o.put((uint8_t) n);
+      for (uint32_t k = 0; k < n; ++k) o.put((int32_t) face_index[j++]);
+      o.end();
+    }
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == nullptr) {
+      std::cerr << "Cannot open " << filename << std::endl;
+      return false;
+    }
+    const bool ok = (fwrite(out.data(), 1, out.size(), fp) == out.size());
+    return (fclose(fp) == 0) && ok;
+  };
+
+ private:
+
+  Format format_ = BINARY_LITTLE_ENDIAN;
+  bool isSaveDouble_ = false;
+
+  enum Type { NONE = -1, INT8 = 0, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+  struct Property {
+    std::string name;
+    Type type = NONE;
+    Type count_type = NONE;  // list property when not NONE
+    size_t offset = 0;       // in a fixed-size record
+  };
+
+  struct Element {
+    std::string name;
+    size_t count = 0;
+    std::vector<Property> props;
+    size_t stride = 0;       // record size (binary, no lists)
+    bool fixed = true;       // no list property
+  };
+
+  struct VertexData {
+    std::vector<double> points, normals, texcoords, colors;
+    bool has_normal = false, has_texcoord = false, has_color = false;
+  };
+
+  static size_t typeSize(Type t) {
+    static const size_t size[] = {1, 1, 2, 2, 4, 4, 4, 8};
+    return (t == NONE) ? 0 : size[t];
+  };
+
+  static Type toType(const std::string& s) {
+    if ((s == "char") || (s == "int8")) return INT8;
+    if ((s == "uchar") || (s == "uint8")) return UINT8;
+    if ((s == "short") || (s == "int16")) return INT16;
+    if ((s == "ushort") || (s == "uint16")) return UINT16;
+    if ((s == "int") || (s == "int32")) return INT32;
+    if ((s == "uint") || (s == "uint32")) return UINT32;
+    if ((s == "float") || (s == "float32")) return FLOAT32;
+    if ((s == "double") || (s == "float64")) return FLOAT64;
+    return NONE;
+  };
+
+  static const char* formatName(Format f) {
+    switch (f) {
+      case ASCII: return "ascii";
+      case BINARY_BIG_ENDIAN: return "binary_big_endian";
+      default: return "binary_little_endian";
+    }
+  };
+
+  static bool isLittleEndian() {
+    const uint16_t one = 1;
+    uint8_t b;
+    memcpy(&b, &one, 1);
+    return b == 1;
+  };
+
+  // format, elements and the offset of the body
+  static bool readHeader(const std::string& buf, Format& format,
+                         std::vector<Element>& elements, size_t& body) {
+    const size_t end = buf.find("end_header");
+    if ((buf.compare(0, 3, "ply") != 0) || (end == std::string::npos)) return false;
+    const size_t nl = buf.find('\n', end);
+    body = (nl == std::string::npos) ? buf.size() : nl + 1;
+
+    std::istringstream hs(buf.substr(0, end));
+    std::string line;
+    bool has_format = false;
+    while (std::getline(hs, line)) {
+      std::istringstream ls(line);
+      std::string key;
+      ls >> key;
+      if (key == "format") {
+        std::string f;
+        ls >> f;
+        if (f == "ascii") format = ASCII;
+        else if (f == "binary_little_endian") format = BINARY_LITTLE_ENDIAN;
+        else if (f == "binary_big_endian") format = BINARY_BIG_ENDIAN;
+        else return false;
+        has_format = true;
+      } else if (key == "element") {
+        Element el;
+        ls >> el.name >> el.count;
+        if (!ls) return false;
+        elements.push_back(el);
+      } else if (key == "property") {
+        if (elements.empty()) return false;
+        Element& el = elements.back();
+        Property p;
+        std::string t;
+        ls >> t;
+        if (t == "list") {
+          std::string ct, it;
+          ls >> ct >> it;
+          p.count_type = toType(ct);
+          p.type = toType(it);
+          if (p.count_type == NONE) return false;
+          el.fixed = false;
+        } else {
+          p.type = toType(t);
+        }
+        ls >> p.name;
+        if ((p.type == NONE) || !ls) return false;
+        p.offset = el.stride;
+        el.stride += typeSize(p.type);
+        el.props.push_back(p);
+      }
+    }
+    return has_format;
+  };
+
+  // binary value at p
+  template <class T>
+  static T load(const char* p, bool swap) {
+    T v;
+    if (swap) {
+      char b[sizeof(T)];
+      for (size_t i = 0; i < sizeof(T); ++i) b[i] = p[sizeof(T) - 1 - i];
+      memcpy(&v, b, sizeof(T));
+    } else {
+      memcpy(&v, p, sizeof(T));
+    }
+    return v;
+  };
+
+  static double load(const char* p, Type t, bool swap) {
+    switch (t) {
+      case INT8: return (double) load<int8_t>(p, swap);
+      case UINT8: return (double) load<uint8_t>(p, swap);
+      case INT16: return (double) load<int16_t>(p, swap);
+      case UINT16: return (double) load<uint16_t>(p, swap);
+      case INT32: return (double) load<int32_t>(p, swap);
+      case UINT32: return (double) load<uint32_t>(p, swap);
+      case FLOAT32: return (double) load<float>(p, swap);
+      case FLOAT64: return load<double>(p, swap);
+      default: return 0.0;
+    }
+  };
+
+  // sequential reads of the body; ok() turns false on a short file or
+  // a malformed number
+  class Body {
+   public:
+    Body(const char* b, const char* e, Format f)
+        : p_(b), e_(e), ascii_(f == ASCII),
+          swap_((f == BINARY_BIG_ENDIAN) == isLittleEndian()) {};
+
+    double get(Type t) {
+      if (!ok_) return 0.0;
+      if (ascii_) {
+        while ((p_ < e_) && isspace((unsigned char) *p_)) ++p_;
+        const char* b = p_;
+        if ((b < e_) && (*b == '+')) ++b;
+        double v = 0.0;
+        auto r = std::from_chars(b, e_, v);
+        if (r.ec != std::errc()) {
+          ok_ = false;
+          return 0.0;
+        }
+        p_ = r.ptr;
+        return v;
+      }
+      const size_t n = typeSize(t);
+      if ((size_t) (e_ - p_) < n) {
+        ok_ = false;
+        return 0.0;
+      }
+      const double v = load(p_, t, swap_);
+      p_ += n;
+      return v;
+    };
+
+    // n fixed-size binary records in place (nullptr when too short)
+    const char* records(size_t n, size_t stride) {
+      if (!ok_ || ascii_ || (stride && ((size_t) (e_ - p_) / stride < n))) return nullptr;
+      const char* r = p_;
+      p_ += n * stride;
+      return r;
+    };
+
+    size_t remaining() const { return (size_t) (e_ - p_); };
+    bool ascii() const { return ascii_; };
+    bool swap() const { return swap_; };
+    bool ok() const { return ok_; };
+
+   private:
+    const char* p_;
+    const char* e_;
+    bool ascii_;
+    bool swap_;
+    bool ok_ = true;
+  };
+
+  static int find(const Element& el, const char* name) {
+    for (size_t i = 0; i < el.props.size(); ++i)
+      if ((el.props[i].name == name) && (el.props[i].count_type == NONE)) return (int) i;
+    return -1;
+  };
+
+  static int find(const Element& el, const char* a, const char* b, const char* c) {
+    int i = find(el, a);
+    if (i < 0) i = find(el, b);
+    if (i < 0) i = find(el, c);
+    return i;
+  };
+
+  // colors of integer types are scaled to [0, 1]
+  static double colorScale(Type t) {
+    if (t == UINT8) return 1.0 / 255.0;
+    if (t == UINT16) return 1.0 / 65535.0;
+    return 1.0;
+  };
+
+  bool readVertices(const Element& el, Body& in, VertexData& vd) {
+    const size_t n = el.count;
+    // slot of each property: 0-2 point, 3-5 normal, 6-7 texcoord, 8-10 color
+    std::vector<int> slot(el.props.size(), -1);
+    const int idx[11] = {find(el, "x"), find(el, "y"), find(el, "z"),
+                         find(el, "nx"), find(el, "ny"), find(el, "nz"),
+                         find(el, "s", "u", "texture_u"), find(el, "t", "v", "texture_v"),
+                         find(el, "red"), find(el, "green"), find(el, "blue")};
+    for (int k = 0; k < 11; ++k)
+      if (idx[k] >= 0) slot[idx[k]] = k;
+    vd.has_normal = (idx[3] >= 0) && (idx[4] >= 0) && (idx[5] >= 0);
+    vd.has_texcoord = (idx[6] >= 0) && (idx[7] >= 0);
+    vd.has_color = (idx[8] >= 0) && (idx[9] >= 0) && (idx[10] >= 0);
+    double scale[3] = {1.0, 1.0, 1.0};
+    for (int k = 0; k < 3; ++k)
+      if (idx[8 + k] >= 0) scale[k] = colorScale(el.props[idx[8 + k]].type);
+
+    if ((n > 0) && ((idx[0] < 0) || (idx[1] < 0) || (idx[2] < 0))) return false;
+
+    // sized only after the body is known to hold the records
+    auto resize = [&](size_t m) {
+      vd.points.resize(3 * m, 0.0);
+      if (vd.has_normal) vd.normals.resize(3 * m, 0.0);
+      if (vd.has_texcoord) vd.texcoords.resize(2 * m, 0.0);
+      if (vd.has_color) vd.colors.resize(3 * m, 0.0);
+    };
+    auto store = [&](size_t i, int k, double v) {
+      if (k < 3) vd.points[3 * i + k] = v;
+      else if (k < 6) { if (vd.has_normal) vd.normals[3 * i + k - 3] = v; }
+      else if (k < 8) { if (vd.has_texcoord) vd.texcoords[2 * i + k - 6] = v; }
+      else if (vd.has_color) vd.colors[3 * i + k - 8] = v * scale[k - 8];
+    };
+
+    if (!in.ascii() && el.fixed) {
+      // fixed-size records: decoded in parallel in place
+      const char* rec = in.records(n, el.stride);
+      if (rec == nullptr) return (n == 0) && in.ok();
+      resize(n);
+      const bool swap = in.swap();
+      par_util::parallelFor(0, n, [&](size_t i) {
+        const char* r = rec + i * el.stride;
+        for (size_t j = 0; j < el.props.size(); ++j)
+          if (slot[j] >= 0) store(i, slot[j], load(r + el.props[j].offset, el.props[j].type, swap));
+      });
+      return true;
+    }
+
+    // grown as records are read
+    for (size_t i = 0; i < n; ++i) {
+      resize(i + 1);
+      for (size_t j = 0; j < el.props.size(); ++j) {
+        const Property& p = el.props[j];
+        if (p.count_type != NONE) {
+          const size_t m = (size_t) in.get(p.count_type);
+          for (size_t k = 0; (k < m) && in.ok(); ++k) in.get(p.type);
+        } else {
+          const double v = in.get(p.type);
+          if (slot[j] >= 0) store(i, slot[j], v);
+        }
+      }
+      if (!in.ok()) return false;
+    }
+    return true;
+  };
+
+  bool readFaces(const Element& el, Body& in, std::vector<size_t>& face_offset,
+                 std::vector<int64_t>& face_index) {
+    int list = -1;
+    for (size_t j = 0; j < el.props.size(); ++j)
+      if ((el.props[j].count_type != NONE) &&
+          ((el.props[j].name == "vertex_indices") || (el.props[j].name == "vertex_index")))
+        list = (int) j;
+    if (list < 0) return skip(el, in);
+    // a record takes at least one byte, so this never exceeds the body
+    const size_t n = std::min(el.count, in.remaining());
+    face_offset.reserve(n + 1);
+    face_index.reserve(3 * n);
+    for (size_t i = 0; i < el.count; ++i) {
+      for (size_t j = 0; j < el.props.size(); ++j) {
+        const Property& p = el.props[j];
+        if (p.count_type != NONE) {
+          const size_t m = (size_t) in.get(p.count_type);
+          for (size_t k = 0; (k < m) && in.ok(); ++k) {
+            const double v = in.get(p.type);
+            if ((int) j == list) face_index.push_back((int64_t) v);
+          }
+        } else {
+          in.get(p.type);
+        }
+      }
+      if (!in.ok()) return false;
+      face_offset.push_back(face_index.size());
+    }
+    return true;
+  };
+
+  bool skip(const Element& el, Body& in) {
+    if (!in.ascii() && el.fixed) return (in.records(el.count, el.stride) != nullptr) || (el.count == 0);
+    for (size_t i = 0; i < el.count; ++i) {
+      for (const Property& p : el.props) {
+        const size_t m = (p.count_type != NONE) ? (size_t) in.get(p.count_type) : 1;
+        for (size_t k = 0; (k < m) && in.ok(); ++k) in.get(p.type);
+      }
+      if (!in.ok()) return false;
+    }
+    return true;
+  };
+
+  // true while v is set to a single value
+  template <class T>
+  static bool assign(T*& v, T* a) {
+    if (a == nullptr) return true;
+    if (v == nullptr) v = a;
+    return v == a;
+  };
+
+  // body output (binary bytes or ASCII text, one record per line)
+  class Out {
+   public:
+    Out(std::string& out, Format f)
+        : out_(out), ascii_(f == ASCII), swap_((f == BINARY_BIG_ENDIAN) == isLittleEndian()) {};
+
+    template <class T>
+    void put(T v) {
+      if (ascii_) {
+        if (!first_) out_.push_back(' ');
+        first_ = false;
+        char tmp[32];
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), number(v));
+        out_.append(tmp, r.ptr - tmp);
+        return;
+      }
+      char b[sizeof(T)];
+      memcpy(b, &v, sizeof(T));
+      if (swap_) std::reverse(b, b + sizeof(T));
+      out_.append(b, sizeof(T));
+    };
+
+    void end() {
+      if (ascii_) out_.push_back('\n');
+      first_ = true;
+    };
+
+   private:
+    std::string& out_;
+    bool ascii_;
+    bool swap_;
+    bool first_ = true;
+
+    // uint8_t as a number, not a character
+    static int number(uint8_t v) { return v; };
+    template <class T>
+    static T number(T v) { return v; };
+  };
+};
+
+#endif // _PLYLIO_HXX
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////
+//
+// Typed per-element properties for MeshL.
+//
+// A property is a named std::vector<T> indexed by element id (vertex,
+// face or halfedge).  Algorithms attach scratch data with
+// MeshL::addVertexProperty<T>("name") instead of side maps keyed by
+// shared_ptr; unused properties cost nothing.  Arrays grow on demand
+// when elements with larger ids are accessed.
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _PROPERTYL_HXX
+#define _PROPERTYL_HXX 1
+
+#include "envDep.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+class BasePropertyL {
+
+public:
+
+  explicit BasePropertyL( const std::string& name ) : name_(name) {};
+  virtual ~BasePropertyL() {};
+
+  const std::string& name() const { return name_; };
+  virtual const std::type_info& type() const = 0;
+  virtual size_t size() const = 0;
+  virtual void resize( size_t n ) = 0;
+  // entry of id i moves to new_id[i] (new_id[i] < 0: dropped)
+  virtual void permute( const std::vector<int>& new_id, size_t n ) = 0;
+
+private:
+
+  std::string name_;
+};
+
+template <class T>
+class PropertyL : public BasePropertyL {
+
+  // std::vector<bool> has no T&; use char for flags
+  static_assert(!std::is_same<T, bool>::value, "PropertyL<bool>: use char");
+
+public:
+
+  PropertyL( const std::string& name, const T& init = T() )
+    : BasePropertyL(name), init_(init) {};
+
+  const std::type_info& type() const override { return typeid(T); };
+  size_t size() const override { return data_.size(); };
+  void resize( size_t n ) override { data_.resize(n, init_); };
+
+  void permute( const std::vector<int>& new_id, size_t n ) override {
+    std::vector<T> d(n, init_);
+    const size_t m = std::min(new_id.size(), data_.size());
+    for (size_t i = 0; i < m; ++i)
+      if ((new_id[i] >= 0) && ((size_t) new_id[i] < n)) d[new_id[i]] = data_[i];
+    data_.swap(d);
+  };
+
+  // access by id (grows the array); id must not be negative
+  T& operator[]( int id ) {
+    assert( id >= 0 );
+    if ((size_t) id >= data_.size()) data_.resize((size_t) id + 1, init_);
+    return data_[id];
+  };
+  // read access; negative ids and ids past the end read the initial value
+  const T& operator[]( int id ) const {
+    return ((id >= 0) && ((size_t) id < data_.size())) ? data_[id] : init_;
+  };
+
+  template <class E>
+  T& operator[]( const std::shared_ptr<E>& e ) { return (*this)[e->id()]; };
+  template <class E>
+  const T& operator[]( const std::shared_ptr<E>& e ) const { return (*this)[e->id()]; };
+
+  // every entry to v
+  void fill( const T& v ) { std::fill(data_.begin(), data_.end(), v); };
+
+  const T& initialValue() const { return init_; };
+  std::vector<T>& data() { return data_; };
+  const std::vector<T>& data() const { return data_; };
+
+private:
+
+  T init_;
+  std::vector<T> data_;
+};
+
+// named properties of one element kind
+class PropertyRegistryL {
+
+public:
+
+  PropertyRegistryL() {};
+
+  // the property named name; created (n entries of init) if missing.
+  // nullptr if a property with that name has another type
+  template <class T>
+  std::shared_ptr<PropertyL<T> > add( const std::string& name, const T& init, size_t n ) {
+    auto it = props_.find(name);
+    if (it != props_.end()) return std::dynamic_pointer_cast<PropertyL<T> >(it->second);
+    std::shared_ptr<PropertyL<T> > p = std::make_shared<PropertyL<T> >(name, init);
+    p->resize(n);
+    props_[name] = p;
+    return p;
+  };
+
+  // nullptr if missing or of another type
+  template <class T>
+  std::shared_ptr<PropertyL<T> > get( const std::string& name ) const {
+    auto it = props_.find(name);
+    if (it == props_.end()) return nullptr;
+    return std::dynamic_pointer_cast<PropertyL<T> >(it->second);
+  };
+
+  bool exists( const std::string& name ) const { return props_.count(name) != 0; };
+  bool remove( const std::string& name ) { return props_.erase(name) != 0; };
+  void clear() { props_.clear(); };
+  bool empty() const { return props_.empty(); };
+
+  // ids were renumbered (see BasePropertyL::permute)
+  void permute( const std::vector<int>& new_id, size_t n ) {
+    for (auto& p : props_) p.second->permute(new_id, n);
+  };
+
+  std::vector<std::string> names() const {
+    std::vector<std::string> n;
+    for (auto& p : props_) n.push_back(p.first);
+    return n;
+  };
+
+private:
+
+  std::map<std::string, std::shared_ptr<BasePropertyL> > props_;
+};
+
+#endif // _PROPERTYL_HXX
@@ -18,6 +18,9 @@
 //using namespace std;
 
 #include "LIO.hxx"
+#include "ObjParserL.hxx"
+#include "ObjWriterL.hxx"
+#include "ParallelFor.hxx"
 #include "myEigen.hxx"
 #include "strutil.h"
 #include "tokenizer.h"
@@ -33,189 +36,120 @@ class SMFLIO : public LIO {
 
   bool inputFromFile(const char* const filename) {
     //
-    // file open
+    // file read (one block)
     //
-    std::ifstream ifs;
-    ifs.open(filename);
-    if (!ifs.is_open()) {
+    std::string buf;
+    if (!ObjParserL::readFile(filename, buf)) {
       std::cerr << "Cannot open " << filename << std::endl;
       return false;
     }
 
+    //
+    // parse newline-aligned chunks in parallel
+    //
+    const int nchunks = par_util::numChunks(buf.size(), 1 << 20);
+    auto ranges = ObjParserL::splitLines(buf.data(), buf.size(), nchunks);
+    std::vector<ObjChunkL> chunks(ranges.size());
+    par_util::forChunks(ranges.size(), (int) ranges.size(), [&](size_t b, size_t e, int) {
+      for (size_t c = b; c < e; ++c)
+        ObjParserL::parse(buf.data() + ranges[c].first, buf.data() + ranges[c].second, chunks[c]);
+    });
+
+    //
+    // build the mesh in file order
+    //
     // for refering vertex pointer
     std::vector<std::shared_ptr<VertexL> > vertex_p;
     std::vector<std::shared_ptr<NormalL> > normal_p;
     std::vector<std::shared_ptr<TexcoordL> > tcoord_p;
-    int v_count = 0;
-    int f_count = 0;
-    //
-    // parse smf
-    //
-    std::string cline;
-    StrUtil strutil;
-    while (getline(ifs, cline, '\n')) {
-      std::string fw;
-      strutil.first_word(cline, fw);
-
-      // comment
-      if (mycomment(cline[0])) continue;
-
-      
-      // read vertices
-      else if (!fw.compare("v")) {
-        std::istringstream isstr(cline);
-
-        // "v"
-        std::string str;
-        isstr >> str;
-        double x, y, z;
-        isstr >> x;
-        isstr >> y;
-        isstr >> z;
-        Eigen::Vector3d p(x, y, z);
-
-        std::shared_ptr<VertexL> vt = mesh().addVertex(p);
-        double r, g, b;
-        if (isstr >> r) {
-          isstr >> g >> b;
-          vt->setColor(r, g, b);
-        }
-        vertex_p.push_back(vt);
-
-        ++v_count;
-      }
-
-      // read normals (Wavefront OBJ: vn; legacy SMF-style: n)
-      else if (!fw.compare("vn") || !fw.compare("n")) {
-        std::istringstream isstr(cline);
-
-        std::string str;
-        isstr >> str;
-        double x, y, z;
-        isstr >> x;
-        isstr >> y;
-        isstr >> z;
-        Eigen::Vector3d p(x, y, z);
-
-        std::shared_ptr<NormalL> nm = mesh().addNormal(p);
-        normal_p.push_back(nm);
-      }
-
-      // read texture coordinates
-      else if (!fw.compare("r") || !fw.compare("vt")) {
-        std::istringstream isstr(cline);
-
-        // "r"
-        std::string str;
-        isstr >> str;
-        double x, y, z;
-        isstr >> x;
-        isstr >> y;
-        if (isstr)
-          isstr >> z;
-        else
-          z = .0;
-        Eigen::Vector3d p(x, y, z);
-
-        std::shared_ptr<TexcoordL> tc = mesh().addTexcoord(p);
-        tcoord_p.push_back(tc);
-      }
-
-      // read faces (Wavefront: f v, f v/vt, f v//vn, f v/vt/vn)
-      else if (!fw.compare("f")) {
-        std::istringstream isstr(cline);
-
-        // "f"
-        std::string str;
-        isstr >> str;
-
-        std::shared_ptr<FaceL> fc = mesh().addFace();
-        while (isstr >> str) {
-          // Keep empty fields so "1//2" → {"1","","2"}
-          std::vector<std::string> parts;
-          {
-            size_t start = 0;
-            for (size_t i = 0; i <= str.size(); ++i) {
-              if (i == str.size() || str[i] == '/') {
-                parts.push_back(str.substr(start, i - start));
-                start = i + 1;
-              }
+    std::vector<FaceL*> faces;
+    for (auto& ch : chunks) {
+      size_t iv = 0, ic = 0, icorner = 0, iface = 0, ib = 0, ibloop = 0;
+      for (uint8_t kind : ch.kinds) {
+        switch (kind) {
+          case ObjChunkL::VERTEX: {
+            const double* x = &ch.values[iv];
+            Eigen::Vector3d p(x[0], x[1], x[2]);
+            std::shared_ptr<VertexL> vt = mesh().addVertex(p);
+            if (ch.colored[ic++]) {
+              vt->setColor(x[3], x[4], x[5]);
+              iv += 3;
             }
+            iv += 3;
+            vertex_p.push_back(vt);
+            break;
           }
-          if (parts.empty() || parts[0].empty()) continue;
-
-          int id;
-          {
-            std::istringstream ai(parts[0]);
-            ai >> id;
+          case ObjChunkL::NORMAL: {
+            const double* x = &ch.values[iv];
+            Eigen::Vector3d p(x[0], x[1], x[2]);
+            normal_p.push_back(mesh().addNormal(p));
+            iv += 3;
+            break;
+          }
+          case ObjChunkL::TEXCOORD: {
+            const double* x = &ch.values[iv];
+            Eigen::Vector3d p(x[0], x[1], x[2]);
+            tcoord_p.push_back(mesh().addTexcoord(p));
+            iv += 3;
+            break;
           }
-          if (id < 1 || id > static_cast<int>(vertex_p.size())) continue;
-          std::shared_ptr<HalfedgeL> he =
-              mesh().addHalfedge(fc, vertex_p[static_cast<size_t>(id - 1)]);
-
-          auto parseIndex = [](const std::string& s, int& out) -> bool {
-            if (s.empty()) return false;
-            std::istringstream ai(s);
-            return static_cast<bool>(ai >> out);
-          };
-
-          if (parts.size() == 2) {
-            // f v/vt  or legacy f v/n (when only normals exist)
-            int idx = 0;
-            if (parseIndex(parts[1], idx)) {
-              if (!(mesh().texcoords().empty())) {
-                if (idx >= 1 && idx <= static_cast<int>(tcoord_p.size()))
-                  he->setTexcoord(tcoord_p[static_cast<size_t>(idx - 1)]);
-              } else if (!(mesh().normals().empty())) {
-                if (idx >= 1 && idx <= static_cast<int>(normal_p.size()))
-                  he->setNormal(normal_p[static_cast<size_t>(idx - 1)]);
+          case ObjChunkL::FACE: {
+            std::shared_ptr<FaceL> fc = mesh().addFace();
+            const int n = ch.face_sizes[iface++];
+            for (int i = 0; i < n; ++i) {
+              const ObjChunkL::Corner& c = ch.corners[icorner++];
+              if (c.v < 1 || c.v > static_cast<int>(vertex_p.size())) continue;
+              std::shared_ptr<HalfedgeL> he =
+                  mesh().addHalfedge(fc, vertex_p[static_cast<size_t>(c.v - 1)]);
+              if (c.nparts == 2) {
+                // f v/vt  or legacy f v/n (when only normals exist)
+                if (c.t == ObjChunkL::kNone) continue;
+                if (!(mesh().texcoords().empty())) {
+                  if (c.t >= 1 && c.t <= static_cast<int>(tcoord_p.size()))
+                    he->setTexcoord(tcoord_p[static_cast<size_t>(c.t - 1)]);
+                } else if (!(mesh().normals().empty())) {
+                  if (c.t >= 1 && c.t <= static_cast<int>(normal_p.size()))
+                    he->setNormal(normal_p[static_cast<size_t>(c.t - 1)]);
+                }
+              } else if (c.nparts >= 3) {
+                // f v/vt/vn or f v//vn
+                if (c.t != ObjChunkL::kNone && !(mesh().texcoords().empty())) {
+                  if (c.t >= 1 && c.t <= static_cast<int>(tcoord_p.size()))
+                    he->setTexcoord(tcoord_p[static_cast<size_t>(c.t - 1)]);
+                }
+                if (c.n != ObjChunkL::kNone && !(mesh().normals().empty())) {
+                  if (c.n >= 1 && c.n <= static_cast<int>(normal_p.size()))
+                    he->setNormal(normal_p[static_cast<size_t>(c.n - 1)]);
+                }
               }
             }
-          } else if (parts.size() >= 3) {
-            // f v/vt/vn or f v//vn
-            int idx = 0;
-            if (parseIndex(parts[1], idx) && !(mesh().texcoords().empty())) {
-              if (idx >= 1 && idx <= static_cast<int>(tcoord_p.size()))
-                he->setTexcoord(tcoord_p[static_cast<size_t>(idx - 1)]);
-            }
-            if (parseIndex(parts[2], idx) && !(mesh().normals().empty())) {
-              if (idx >= 1 && idx <= static_cast<int>(normal_p.size()))
-                he->setNormal(normal_p[static_cast<size_t>(idx - 1)]);
-            }
+            faces.push_back(fc.get());
+            break;
           }
-        }
-
-        fc->calcNormal();
-
-        ++f_count;
-      }
-
-      // read boundary loop
-      else if (!fw.compare("b")) {
-        std::istringstream isstr(cline);
-
-        // "b"
-        std::string str;
-        isstr >> str;
-
-        std::shared_ptr<BLoopL> bl = mesh().addBLoop();
-        int id;
-        while (isstr >> id) {
-          if (id > 0) {
-            bl->addIsCorner(true);
-          } else {
-            bl->addIsCorner(false);
-            id *= -1;  // reverse
+          case ObjChunkL::BLOOP: {
+            std::shared_ptr<BLoopL> bl = mesh().addBLoop();
+            const int n = ch.bloop_sizes[ibloop++];
+            for (int i = 0; i < n; ++i) {
+              int id = ch.bloop[ib++];
+              const bool is_corner = (id > 0);
+              if (!is_corner) id *= -1;  // reverse
+              if (id < 1 || id > static_cast<int>(vertex_p.size())) continue;
+              bl->addIsCorner(is_corner);
+              bl->addVertex(vertex_p[id - 1]);
+            }
+            std::cout << "b: " << bl->vertices().size() << " vertices."
+                      << std::endl;
+            break;
           }
-          bl->addVertex(vertex_p[id - 1]);
         }
-        std::cout << "b: " << bl->vertices().size() << " vertices."
-                  << std::endl;
       }
+      ch.clear();
+    }
 
-    }  // while
-
-    ifs.close();
+    // face normals
+    par_util::parallelFor(0, faces.size(), [&](size_t i) {
+      if (faces[i]->size() >= 3) faces[i]->calcNormal();
+    });
 
     mesh().printInfo();
 
@@ -257,95 +191,136 @@ class SMFLIO : public LIO {
     int nn = mesh().normals().size();
     int fn = mesh().faces().size();
 
-    ofs << "####" << std::endl;
-    ofs << "#" << std::endl;
-    ofs << "# OBJ File Generated by hsphparam" << std::endl;
-    ofs << "#" << std::endl;
-    ofs << "####" << std::endl;
-    ofs << "#" << std::endl;
-    ofs << "# Vertices: " << vn << std::endl;
-    if (nn && isSaveNormal()) ofs << "# Normals: " << nn << std::endl;
-    if (tn && isSaveTexcoord()) ofs << "# Texcoords: " << tn << std::endl;
-    ofs << "# Faces: " << fn << std::endl;
-    ofs << "#" << std::endl;
-    ofs << "####" << std::endl;
+    std::string out;
+    ObjWriterL::put(out, "####\n#\n# OBJ File Generated by hsphparam\n#\n####\n#\n");
+    ObjWriterL::put(out, "# Vertices: ");
+    ObjWriterL::put(out, vn);
+    ObjWriterL::put(out, '\n');
+    if (nn && isSaveNormal()) {
+      ObjWriterL::put(out, "# Normals: ");
+      ObjWriterL::put(out, nn);
+      ObjWriterL::put(out, '\n');
+    }
+    if (tn && isSaveTexcoord()) {
+      ObjWriterL::put(out, "# Texcoords: ");
+      ObjWriterL::put(out, tn);
+      ObjWriterL::put(out, '\n');
+    }
+    ObjWriterL::put(out, "# Faces: ");
+    ObjWriterL::put(out, fn);
+    ObjWriterL::put(out, "\n#\n####\n");
 
+    //
+    // ids (1-based) are set first; the sections are then formatted in
+    // parallel chunks and written at once
+    //
     if (vn) {
+      std::vector<VertexL*> vts;
+      vts.reserve(vn);
       int id = 1;
       for ( auto& vt : mesh().vertices() ) {
+        vt->setID(id);
+        id++;
+        vts.push_back(vt.get());
+      }
+      const bool denormalize = mesh().isNormalized() && !(isSaveNormalization());
+      const double len = mesh().maxLength();
+      const Eigen::Vector3d center = mesh().center();
+      ObjWriterL::format(vts.size(), out, [&](size_t i, std::string& buf) {
+        VertexL* vt = vts[i];
         Eigen::Vector3d& p = vt->point();
-        if (mesh().isNormalized() && !(isSaveNormalization())) {
-          p *= mesh().maxLength();
-          p += mesh().center();
+        if (denormalize) {
+          p *= len;
+          p += center;
         }
-        ofs << "v " << p.x() << " " << p.y() << " " << p.z();
+        ObjWriterL::put(buf, "v ");
+        ObjWriterL::put3(buf, p);
         if (isSaveColor() && vt->hasColor()) {
-          const Eigen::Vector3d& c = vt->color();
-          ofs << " " << c.x() << " " << c.y() << " " << c.z();
+          ObjWriterL::put(buf, ' ');
+          ObjWriterL::put3(buf, vt->color());
         }
-        ofs << std::endl;
-        vt->setID(id);
-        id++;
-      }
+        ObjWriterL::put(buf, '\n');
+      });
     }
 
     // int nn = mesh().normals().size();
     if (nn && isSaveNormal()) {
+      std::vector<NormalL*> nms;
+      nms.reserve(nn);
       int id = 1;
       for ( auto& nm : mesh().normals() ) {
-        Eigen::Vector3d& p = nm->point();
-        ofs << "vn " << p.x() << " " << p.y() << " " << p.z() << std::endl;
         nm->setID(id);
         id++;
+        nms.push_back(nm.get());
       }
+      ObjWriterL::format(nms.size(), out, [&](size_t i, std::string& buf) {
+        ObjWriterL::put(buf, "vn ");
+        ObjWriterL::put3(buf, nms[i]->point());
+        ObjWriterL::put(buf, '\n');
+      });
     }
 
     // int tn = mesh().texcoords().size();
     if (tn && isSaveTexcoord()) {
+      std::vector<TexcoordL*> tcs;
+      tcs.reserve(tn);
       int id = 1;
       for ( auto& tc : mesh().texcoords() ) {
-        Eigen::Vector3d& p = tc->point();
-        ofs << "vt " << p.x() << " " << p.y() << " " << p.z() << std::endl;
         tc->setID(id);
         id++;
+        tcs.push_back(tc.get());
       }
+      ObjWriterL::format(tcs.size(), out, [&](size_t i, std::string& buf) {
+        ObjWriterL::put(buf, "vt ");
+        ObjWriterL::put3(buf, tcs[i]->point());
+        ObjWriterL::put(buf, '\n');
+      });
     }
 
     if (fn) {
-      for ( auto& fc : mesh().faces() ) {
-        ofs << "f ";
-        for ( auto& he : fc->halfedges() ) {
-          ofs << he->vertex()->id();
-          const bool has_n = he->normal() && isSaveNormal();
-          const bool has_t = he->texcoord() && isSaveTexcoord();
+      std::vector<FaceL*> fcs;
+      fcs.reserve(fn);
+      for ( auto& fc : mesh().faces() ) fcs.push_back(fc.get());
+      ObjWriterL::format(fcs.size(), out, [&](size_t i, std::string& buf) {
+        ObjWriterL::put(buf, "f ");
+        for ( auto& he : fcs[i]->halfedges() ) {
+          ObjWriterL::put(buf, he->vertexRaw()->id());
+          NormalL* nm = isSaveNormal() ? he->normalRaw() : nullptr;
+          TexcoordL* tc = isSaveTexcoord() ? he->texcoordRaw() : nullptr;
           // Wavefront: f v, f v/vt, f v//vn, f v/vt/vn
-          if (has_t || has_n) {
-            ofs << "/";
-            if (has_t) ofs << he->texcoord()->id();
-            if (has_n) ofs << "/" << he->normal()->id();
+          if (tc || nm) {
+            ObjWriterL::put(buf, '/');
+            if (tc) ObjWriterL::put(buf, tc->id());
+            if (nm) {
+              ObjWriterL::put(buf, '/');
+              ObjWriterL::put(buf, nm->id());
+            }
           }
-          ofs << " ";
+          ObjWriterL::put(buf, ' ');
         }
-        ofs << std::endl;
-      }
+        ObjWriterL::put(buf, '\n');
+      });
     }
 
     // save bloop
     if (isSaveBLoop() && mesh().bloops().size()) {
       std::shared_ptr<BLoopL> bl = *(mesh().bloops().begin());
 
-      ofs << "b\t";
+      ObjWriterL::put(out, "b\t");
       for (unsigned int i = 0; i < bl->vertices().size(); ++i) {
         int id = bl->vertex(i)->id();
 
         if (!(bl->isCorner(i))) id *= -1;  // reverse
 
-        ofs << id << " ";
+        ObjWriterL::put(out, id);
+        ObjWriterL::put(out, ' ');
       }
-      ofs << std::endl;
+      ObjWriterL::put(out, '\n');
     }
 
+    ofs.write(out.data(), out.size());
     ofs.close();
+    const bool ok = !ofs.fail();
 
     // reset numbers
 
@@ -370,8 +345,9 @@ class SMFLIO : public LIO {
         id++;
       }
     }
+    mesh().invalidateIDIndex();
 
-    return true;
+    return ok;
   };
 
  private:
@@ -42,13 +42,18 @@ public:
   };
 
   // color (optional per-vertex RGB, e.g. baked AO)
-  bool hasColor() const { return has_color_; };
-  const Eigen::Vector3d& color() const { return color_; };
-  void setColor( const Eigen::Vector3d& c ) { color_ = c; has_color_ = true; };
+  // stored only for vertices that have one; color() is zero otherwise
+  bool hasColor() const { return color_ != nullptr; };
+  const Eigen::Vector3d& color() const {
+    static const Eigen::Vector3d zero = Eigen::Vector3d::Zero();
+    return color_ ? *color_ : zero;
+  };
+  void setColor( const Eigen::Vector3d& c ) { setColor( c.x(), c.y(), c.z() ); };
   void setColor( double r, double g, double b ) {
-    color_ << r, g, b;
-    has_color_ = true;
+    if ( !color_ ) color_.reset( new Eigen::Vector3d );
+    *color_ << r, g, b;
   };
+  void clearColor() { color_.reset(); };
 
   // iter
   void setIter( std::list<std::shared_ptr<VertexL> >::iterator iter ) { iter_ = iter; };
@@ -59,14 +64,14 @@ public:
   //
   std::shared_ptr<HalfedgeL> halfedge() const { return halfedge_; }
   void setHalfedge(std::shared_ptr<HalfedgeL> halfedge) { halfedge_ = halfedge; }
+  HalfedgeL* halfedgeRaw() const { return halfedge_.get(); }
 
 private:
 
   // 3D coord
   Eigen::Vector3d point_;
 
-  bool has_color_ = false;
-  Eigen::Vector3d color_ = Eigen::Vector3d::Zero();
+  std::unique_ptr<Eigen::Vector3d> color_;
 
   // one of halfedges
   std::shared_ptr<HalfedgeL> halfedge_;
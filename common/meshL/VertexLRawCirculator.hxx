@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////
+//
+// Non-owning one-ring circulators over raw pointers.
+//
+// Same traversal as VertexLCirculator (outgoing halfedges via
+// prev()->mate(), stopping at a boundary or back at the start), but
+// walks HalfedgeL* and never copies a shared_ptr, so no reference
+// count is touched.  Loops only read the mesh and may run from several
+// threads at once; the pointers are valid while the mesh is not edited.
+//
+//   VertexLRawCirculator vc( vt.get() );
+//   for (HalfedgeL* he : vc.halfedges()) ...
+//   for (VertexL* nv : vc.vertices()) ...   // boundary: also the last one
+//   for (FaceL* fc : vc.faces()) ...
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _VERTEXLRAWCIRCULATOR_HXX
+#define _VERTEXLRAWCIRCULATOR_HXX 1
+
+#include "envDep.h"
+
+#include <cstddef>
+#include <iterator>
+
+#include "VertexL.hxx"
+#include "HalfedgeL.hxx"
+#include "FaceL.hxx"
+
+class VertexLRawCirculator {
+
+public:
+
+  // outgoing halfedges; operator* maps the current one to the element
+  template <class T, class Deref>
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T**;
+    using reference = T*;
+
+    Iterator() {};
+    Iterator( HalfedgeL* first ) : he_(first), first_(first) {};
+
+    T* operator*() const { return Deref()(he_, last_); };
+
+    Iterator& operator++() {
+      if ( last_ ) { he_ = nullptr; last_ = false; return *this; }
+      HalfedgeL* nx = he_->prevRaw()->mateRaw();
+      if ( nx == nullptr ) {
+        // open fan: vertices get one more (the end of the last face)
+        if ( Deref::hasLast ) last_ = true;
+        else he_ = nullptr;
+      } else if ( nx == first_ ) {
+        he_ = nullptr;
+      } else {
+        he_ = nx;
+      }
+      return *this;
+    };
+    Iterator operator++(int) { Iterator it = *this; ++(*this); return it; };
+
+    bool operator==( const Iterator& o ) const { return (he_ == o.he_) && (last_ == o.last_); };
+    bool operator!=( const Iterator& o ) const { return !(*this == o); };
+
+  private:
+    HalfedgeL* he_ = nullptr;
+    HalfedgeL* first_ = nullptr;
+    bool last_ = false;
+  };
+
+  struct HalfedgeDeref {
+    static constexpr bool hasLast = false;
+    HalfedgeL* operator()( HalfedgeL* he, bool ) const { return he; };
+  };
+  struct FaceDeref {
+    static constexpr bool hasLast = false;
+    FaceL* operator()( HalfedgeL* he, bool ) const { return he->faceRaw(); };
+  };
+  struct VertexDeref {
+    static constexpr bool hasLast = true;
+    VertexL* operator()( HalfedgeL* he, bool last ) const {
+      return last ? he->prevRaw()->vertexRaw() : he->nextRaw()->vertexRaw();
+    };
+  };
+
+  template <class T, class Deref>
+  class Range {
+  public:
+    Range( HalfedgeL* first ) : first_(first) {};
+    Iterator<T, Deref> begin() const { return Iterator<T, Deref>(first_); };
+    Iterator<T, Deref> end() const { return Iterator<T, Deref>(); };
+  private:
+    HalfedgeL* first_;
+  };
+
+  VertexLRawCirculator( const VertexL* vt ) : first_(vt ? vt->halfedgeRaw() : nullptr) {};
+
+  Range<HalfedgeL, HalfedgeDeref> halfedges() const { return Range<HalfedgeL, HalfedgeDeref>(first_); };
+  Range<FaceL, FaceDeref> faces() const { return Range<FaceL, FaceDeref>(first_); };
+  Range<VertexL, VertexDeref> vertices() const { return Range<VertexL, VertexDeref>(first_); };
+
+  HalfedgeL* firstHalfedge() const { return first_; };
+
+  // the fan ends at a halfedge without mate (or there is no face)
+  bool isBoundary() const {
+    if ( first_ == nullptr ) return true;
+    HalfedgeL* he = first_;
+    do {
+      he = he->prevRaw()->mateRaw();
+      if ( he == nullptr ) return true;
+    } while ( he != first_ );
+    return false;
+  };
+
+  int num_vertices() const {
+    int count = 0;
+    for ( VertexL* vt : vertices() ) { (void) vt; ++count; }
+    return count;
+  };
+
+  int num_faces() const {
+    int count = 0;
+    for ( HalfedgeL* he : halfedges() ) { (void) he; ++count; }
+    return count;
+  };
+
+private:
+
+  HalfedgeL* first_;
+};
+
+#endif // _VERTEXLRAWCIRCULATOR_HXX
@@ -66,23 +66,12 @@ inline Method chartStructureMethod(Method user) {
 inline bool meshFromEigen(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F,
                           std::shared_ptr<MeshL>& mesh) {
   mesh = std::make_shared<MeshL>();
-  std::vector<std::shared_ptr<VertexL>> verts(V.rows());
-  for (int i = 0; i < V.rows(); ++i) {
-    Eigen::Vector3d p(V(i, 0), V(i, 1), V(i, 2));
-    verts[i] = mesh->addVertex(p);
-  }
-  for (int fi = 0; fi < F.rows(); ++fi) {
-    if (F(fi, 0) < 0 || F(fi, 1) < 0 || F(fi, 2) < 0 || F(fi, 0) >= V.rows() ||
-        F(fi, 1) >= V.rows() || F(fi, 2) >= V.rows()) {
-      return false;
-    }
-    mesh->addTriangle(verts[F(fi, 0)], verts[F(fi, 1)], verts[F(fi, 2)]);
-  }
+  if (F.cols() != 3) return false;
   const bool restore = MeshL::connectivityWarnings();
   MeshL::setConnectivityWarnings(false);
-  mesh->createConnectivity(true);
+  const bool ok = mesh->buildFromArrays(V, F, true);
   MeshL::setConnectivityWarnings(restore);
-  return true;
+  return ok;
 }
 
 inline bool uvFromMesh(const std::shared_ptr<MeshL>& mesh, const Eigen::MatrixXd& V,
@@ -16,7 +16,6 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
-#include <map>
 #include <memory>
 #include <set>
 #include <vector>
@@ -57,8 +56,10 @@ class SymDirichletParam {
 
     mesh_->createConnectivity(true);
     indexVertices();
-    if (!buildEigenMesh()) return false;
-    if (!importUvFromMesh()) return false;
+    if (!buildEigenMesh() || !importUvFromMesh()) {
+      releaseVertexIndex();
+      return false;
+    }
     fixOrientationAndNormalize();
 
     std::set<int> fixed;
@@ -81,6 +82,7 @@ class SymDirichletParam {
     }
 
     assignTexcoordsFromEigen();
+    releaseVertexIndex();
     if (verbose_) {
       std::cout << "symdirichlet: done. v " << mesh_->vertices_size() << " t "
                 << mesh_->texcoords().size() << std::endl;
@@ -95,7 +97,8 @@ class SymDirichletParam {
   bool quiet_ = true;
   bool free_boundary_ = true;
 
-  std::map<std::shared_ptr<VertexL>, int> vtx_index_;
+  // row of each vertex in V_ (vertex property, -1: not indexed)
+  std::shared_ptr<PropertyL<int> > vtx_index_;
   Eigen::MatrixXd V_;
   Eigen::MatrixXi F_;
   Eigen::MatrixXd UV_;
@@ -116,9 +119,15 @@ class SymDirichletParam {
   }
 
   void indexVertices() {
-    vtx_index_.clear();
+    vtx_index_ = mesh_->addVertexProperty<int>("symdirichlet:index", -1);
+    vtx_index_->fill(-1);
     int i = 0;
-    for (const auto& vt : mesh_->vertices()) vtx_index_[vt] = i++;
+    for (const auto& vt : mesh_->vertices()) (*vtx_index_)[vt] = i++;
+  }
+
+  void releaseVertexIndex() {
+    mesh_->removeVertexProperty("symdirichlet:index");
+    vtx_index_.reset();
   }
 
   bool buildEigenMesh() {
@@ -136,9 +145,9 @@ class SymDirichletParam {
                                                 fc->halfedges().end());
       if (he.size() != 3) return false;
       for (int c = 0; c < 3; ++c) {
-        auto it = vtx_index_.find(he[c]->vertex());
-        if (it == vtx_index_.end()) return false;
-        F_(fi, c) = it->second;
+        const int vi = (*vtx_index_)[he[c]->vertex()];
+        if (vi < 0) return false;
+        F_(fi, c) = vi;
       }
       ++fi;
     }
@@ -165,9 +174,9 @@ class SymDirichletParam {
       for (const auto& he : fc->halfedges()) {
         const auto tc = he->texcoord();
         if (!tc) continue;
-        auto it = vtx_index_.find(he->vertex());
-        if (it == vtx_index_.end()) continue;
-        UV_.row(it->second) = tc->point().head<2>().transpose();
+        const int vi = (*vtx_index_)[he->vertex()];
+        if (vi < 0) continue;
+        UV_.row(vi) = tc->point().head<2>().transpose();
       }
     }
     return true;
@@ -206,8 +215,8 @@ class SymDirichletParam {
     mesh_->createConnectivity(true);
     if (collectLongestBoundaryLoop(mesh_->halfedges(), boundary)) {
       for (const auto& vt : boundary) {
-        auto it = vtx_index_.find(vt);
-        if (it != vtx_index_.end()) fixed.insert(it->second);
+        const int vi = (*vtx_index_)[vt];
+        if (vi >= 0) fixed.insert(vi);
       }
     }
     if (fixed.empty() && UV_.rows() > 0) fixed.insert(0);
@@ -268,9 +277,9 @@ class SymDirichletParam {
                                                   fc->halfedges().end());
       if (hes.size() != 3) continue;
       for (auto& he : hes) {
-        auto it = vtx_index_.find(he->vertex());
-        if (it == vtx_index_.end()) continue;
-        const Eigen::Vector2d uv = UV_.row(it->second);
+        const int vi = (*vtx_index_)[he->vertex()];
+        if (vi < 0) continue;
+        const Eigen::Vector2d uv = UV_.row(vi);
         Eigen::Vector3d p(uv.x(), uv.y(), 0.0);
         he->setTexcoord(mesh_->addTexcoord(p));
       }
@@ -194,6 +194,7 @@ class GLMeshL : public GLMesh {
   GLuint vertex_count_wire() const { return vertex_count_wire_; };
 
   // Update GPU buffers after deforming mesh topology/vertex positions in place.
+  // Smooth normals follow vertices marked by MeshL::markVertexMoved().
   void updateBuffersFromMesh() {
     if (!meshl_) return;
     if (vao_smooth_ == 0) {
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////
+//
+// Minimal std::thread helpers: chunked parallel-for and parallel sort.
+//
+// Work is split into at most numThreads() contiguous chunks; ranges
+// smaller than the given grain run on the calling thread.  Set the
+// thread count with par_util::setNumThreads() (0 = hardware threads).
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _PARALLELFOR_HXX
+#define _PARALLELFOR_HXX 1
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace par_util {
+
+inline int& numThreadsSetting() {
+  static int n = 0;
+  return n;
+}
+
+// n <= 0: use std::thread::hardware_concurrency()
+inline void setNumThreads(int n) { numThreadsSetting() = n; }
+
+inline int numThreads() {
+  int n = numThreadsSetting();
+  if (n <= 0) n = (int) std::thread::hardware_concurrency();
+  return (n <= 0) ? 1 : n;
+}
+
+// number of chunks used for n items (at least grain items per chunk)
+inline int numChunks(size_t n, size_t grain) {
+  if (grain == 0) grain = 1;
+  size_t c = n / grain;
+  if (c < 1) c = 1;
+  return (int) std::min(c, (size_t) numThreads());
+}
+
+// f(begin, end, chunk) for chunk = 0 .. nchunks-1 over [0, n)
+template <class F>
+void forChunks(size_t n, int nchunks, F f) {
+  if (nchunks <= 1) {
+    f((size_t) 0, n, 0);
+    return;
+  }
+  std::vector<std::thread> th;
+  th.reserve(nchunks - 1);
+  for (int c = 1; c < nchunks; ++c) {
+    size_t b = n * c / nchunks;
+    size_t e = n * (c + 1) / nchunks;
+    th.emplace_back([&f, b, e, c]() { f(b, e, c); });
+  }
+  f((size_t) 0, n / nchunks, 0);
+  for (auto& t : th) t.join();
+}
+
+// f(i) for i in [begin, end)
+template <class F>
+void parallelFor(size_t begin, size_t end, F f, size_t grain = 4096) {
+  if (end <= begin) return;
+  const size_t n = end - begin;
+  forChunks(n, numChunks(n, grain), [&f, begin](size_t b, size_t e, int) {
+    for (size_t i = b; i < e; ++i) f(begin + i);
+  });
+}
+
+// chunk-wise std::sort followed by pairwise merges
+template <class T, class Compare>
+void parallelSort(std::vector<T>& v, Compare comp, size_t grain = 1 << 15) {
+  const size_t n = v.size();
+  int nchunks = numChunks(n, grain);
+  if (nchunks <= 1) {
+    std::sort(v.begin(), v.end(), comp);
+    return;
+  }
+  std::vector<size_t> bounds(nchunks + 1);
+  for (int c = 0; c <= nchunks; ++c) bounds[c] = n * c / nchunks;
+
+  forChunks(n, nchunks, [&](size_t, size_t, int c) {
+    std::sort(v.begin() + bounds[c], v.begin() + bounds[c + 1], comp);
+  });
+
+  // merge neighbouring runs until one is left
+  while (bounds.size() > 2) {
+    const int runs = (int) bounds.size() - 1;
+    const int pairs = runs / 2;
+    std::vector<std::thread> th;
+    for (int p = 0; p < pairs; ++p) {
+      size_t b = bounds[2 * p], m = bounds[2 * p + 1], e = bounds[2 * p + 2];
+      th.emplace_back([&v, &comp, b, m, e]() {
+        std::inplace_merge(v.begin() + b, v.begin() + m, v.begin() + e, comp);
+      });
+    }
+    for (auto& t : th) t.join();
+    std::vector<size_t> nb;
+    for (int r = 0; r <= runs; r += 2) nb.push_back(bounds[r]);
+    if (nb.back() != n) nb.push_back(n);
+    bounds.swap(nb);
+  }
+}
+
+}  // namespace par_util
+
+#endif // _PARALLELFOR_HXX
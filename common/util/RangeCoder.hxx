@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////
+//
+// Adaptive binary range coder (LZMA style) with small models on top:
+//
+//   BitTreeModel<NB>  symbols of NB bits, one adaptive probability per
+//                     tree node
+//   IntModel          unsigned integers as an adaptive bit-length
+//                     bucket followed by the lower bits
+//
+// Encoder output is a byte stream independent of the host byte order.
+//
+// Copyright (c) 2026 Takashi Kanai
+// Released under the MIT license
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef _RANGECODER_HXX
+#define _RANGECODER_HXX 1
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rc_util {
+
+static constexpr int kProbBits = 11;
+static constexpr uint16_t kProbInit = 1 << (kProbBits - 1);
+static constexpr int kMoveBits = 5;
+static constexpr uint32_t kTop = 1u << 24;
+
+class RangeEncoder {
+ public:
+  explicit RangeEncoder(std::vector<uint8_t>& out) : out_(out) {};
+
+  void encodeBit(uint16_t& p, int bit) {
+    const uint32_t bound = (range_ >> kProbBits) * p;
+    if (bit == 0) {
+      range_ = bound;
+      p += ((1 << kProbBits) - p) >> kMoveBits;
+    } else {
+      low_ += bound;
+      range_ -= bound;
+      p -= p >> kMoveBits;
+    }
+    while (range_ < kTop) {
+      range_ <<= 8;
+      shiftLow();
+    }
+  };
+
+  // nbits (<= 32) equiprobable bits, up to 16 at a time
+  void encodeDirect(uint32_t v, int nbits) {
+    while (nbits > 0) {
+      const int n = std::min(nbits, 16);
+      nbits -= n;
+      range_ >>= n;
+      low_ += (uint64_t) ((v >> nbits) & ((1u << n) - 1)) * range_;
+      while (range_ < kTop) {
+        range_ <<= 8;
+        shiftLow();
+      }
+    }
+  };
+
+  void flush() {
+    for (int i = 0; i < 5; ++i) shiftLow();
+  };
+
+ private:
+  std::vector<uint8_t>& out_;
+  uint64_t low_ = 0;
+  uint32_t range_ = 0xFFFFFFFFu;
+  uint8_t cache_ = 0;
+  uint64_t cache_size_ = 1;
+
+  void shiftLow() {
+    if ((uint32_t) low_ < 0xFF000000u || (low_ >> 32) != 0) {
+      const uint8_t carry = (uint8_t) (low_ >> 32);
+      uint8_t temp = cache_;
+      do {
+        out_.push_back((uint8_t) (temp + carry));
+        temp = 0xFF;
+      } while (--cache_size_ != 0);
+      cache_ = (uint8_t) (low_ >> 24);
+    }
+    ++cache_size_;
+    low_ = (low_ & 0x00FFFFFFu) << 8;
+  };
+};
+
+// reading past the end yields zero bytes; check overrun() at the end
+class RangeDecoder {
+ public:
+  RangeDecoder(const uint8_t* b, const uint8_t* e) : p_(b), e_(e) {
+    for (int i = 0; i < 5; ++i) code_ = (code_ << 8) | next();
+  };
+
+  int decodeBit(uint16_t& p) {
+    const uint32_t bound = (range_ >> kProbBits) * p;
+    int bit;
+    if (code_ < bound) {
+      range_ = bound;
+      p += ((1 << kProbBits) - p) >> kMoveBits;
+      bit = 0;
+    } else {
+      code_ -= bound;
+      range_ -= bound;
+      p -= p >> kMoveBits;
+      bit = 1;
+    }
+    while (range_ < kTop) {
+      range_ <<= 8;
+      code_ = (code_ << 8) | next();
+    }
+    return bit;
+  };
+
+  uint32_t decodeDirect(int nbits) {
+    uint32_t v = 0;
+    while (nbits > 0) {
+      const int n = std::min(nbits, 16);
+      nbits -= n;
+      range_ >>= n;
+      uint32_t d = code_ / range_;
+      if (d >> n) d = (1u << n) - 1;  // broken stream
+      code_ -= d * range_;
+      v = (v << n) | d;
+      while (range_ < kTop) {
+        range_ <<= 8;
+        code_ = (code_ << 8) | next();
+      }
+    }
+    return v;
+  };
+
+  // more bytes consumed than the stream holds (beyond the flushed tail)
+  bool overrun() const { return overrun_ > 4; };
+
+ private:
+  const uint8_t* p_;
+  const uint8_t* e_;
+  uint32_t code_ = 0;
+  uint32_t range_ = 0xFFFFFFFFu;
+  size_t overrun_ = 0;
+
+  uint32_t next() {
+    if (p_ < e_) return *p_++;
+    ++overrun_;
+    return 0;
+  };
+};
+
+template <int NB>
+class BitTreeModel {
+ public:
+  BitTreeModel() {
+    for (auto& p : probs_) p = kProbInit;
+  };
+
+  void encode(RangeEncoder& rc, uint32_t sym) {
+    uint32_t m = 1;
+    for (int i = NB - 1; i >= 0; --i) {
+      const int bit = (sym >> i) & 1;
+      rc.encodeBit(probs_[m], bit);
+      m = (m << 1) | bit;
+    }
+  };
+
+  uint32_t decode(RangeDecoder& rc) {
+    uint32_t m = 1;
+    for (int i = 0; i < NB; ++i) m = (m << 1) | rc.decodeBit(probs_[m]);
+    return m - (1u << NB);
+  };
+
+ private:
+  uint16_t probs_[1 << NB];
+};
+
+class IntModel {
+ public:
+  void encode(RangeEncoder& rc, uint32_t v) {
+    int n = 0;
+    while ((n < 32) && (v >> n)) ++n;
+    bucket_.encode(rc, (uint32_t) n);
+    if (n > 1) rc.encodeDirect(v & ((1u << (n - 1)) - 1), n - 1);
+  };
+
+  uint32_t decode(RangeDecoder& rc) {
+    const int n = (int) bucket_.decode(rc);
+    if (n == 0) return 0;
+    if (n > 32) return 0;
+    const uint32_t high = 1u << (n - 1);
+    return (n > 1) ? (high | rc.decodeDirect(n - 1)) : high;
+  };
+
+  // signed values
+  void encodeSigned(RangeEncoder& rc, int32_t v) {
+    encode(rc, ((uint32_t) v << 1) ^ (uint32_t) (v >> 31));
+  };
+  int32_t decodeSigned(RangeDecoder& rc) {
+    const uint32_t u = decode(rc);
+    return (int32_t) (u >> 1) ^ -(int32_t) (u & 1);
+  };
+
+ private:
+  BitTreeModel<6> bucket_;
+};
+
+}  // namespace rc_util
+
+#endif  // _RANGECODER_HXX